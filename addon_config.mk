@@ -61,3 +61,19 @@ common:
 	# when parsing the file system looking for libraries exclude this for all or
 	# a specific platform
 	# ADDON_LIBS_EXCLUDE  =
+
+linux64:
+	# shm_open() of SharedMemorySyncGroups (in libc since glibc 2.34)
+	ADDON_LDFLAGS = -lrt
+
+linux:
+	ADDON_LDFLAGS = -lrt
+
+linuxarmv6l:
+	ADDON_LDFLAGS = -lrt
+
+linuxarmv7l:
+	ADDON_LDFLAGS = -lrt
+
+linuxaarch64:
+	ADDON_LDFLAGS = -lrt
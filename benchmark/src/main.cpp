@@ -0,0 +1,670 @@
+// Frame overhead benchmark of ofxTaskRunner (headless, see ../CMakeLists.txt)
+//
+// Measures update() + draw() cost per frame, heap allocations per frame
+// (also of callbacks by capture size, and of queues looped by loop()),
+// staggered wait deadlines, sync wait cost across queue counts and chain
+// lengths, tween evaluation, nested fork / join, dependency graphs, and
+// pooled task storage.
+// Time is advanced by a VirtualClock (1/60 sec per frame), so every run does
+// the same work.
+
+#include "ofxTaskRunner.h"
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+
+// Count heap allocations (reported per frame)
+static std::atomic<size_t> allocation_count(0);
+
+void* operator new(std::size_t size) {
+	allocation_count++;
+	if (void* p = std::malloc(size == 0 ? 1 : size)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	std::free(p);
+}
+
+// (std::pmr::new_delete_resource() allocates with alignment)
+void* operator new(std::size_t size, std::align_val_t alignment) {
+	allocation_count++;
+	std::size_t align = static_cast<std::size_t>(alignment);
+	if (void* p = std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) / align * align)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+	std::free(p);
+}
+
+struct BenchApp {
+	// Incremented by tasks (to keep work from being optimized away)
+	size_t counter = 0;
+};
+
+using Runner = ofxTaskRunner<BenchApp>;
+
+static const double FRAME_SEC = 1.0 / 60.0;
+
+struct FrameStats {
+	int frames = 0;
+	uint64_t total_micros = 0;
+	uint64_t max_micros = 0;
+	size_t total_allocations = 0;
+
+	void add(uint64_t micros, size_t allocations) {
+		frames++;
+		total_micros += micros;
+		max_micros = std::max(max_micros, micros);
+		total_allocations += allocations;
+	}
+
+	double avgMicros() const {
+		return frames > 0 ? total_micros / (double)frames : 0.0;
+	}
+
+	double avgAllocations() const {
+		return frames > 0 ? total_allocations / (double)frames : 0.0;
+	}
+};
+
+/// run one frame (advance clock, update() and draw()) and measure it
+static void runFrame(Runner& runner, taskrunner::clock::VirtualClock& clock, FrameStats& stats) {
+	clock.advanceSec(FRAME_SEC);
+
+	size_t allocations_before = allocation_count;
+	auto started = std::chrono::steady_clock::now();
+	runner.update();
+	runner.draw();
+	auto elapsed = std::chrono::steady_clock::now() - started;
+
+	stats.add(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(), allocation_count - allocations_before);
+}
+
+/// run frames until all task queues finished (or max_frames)
+static FrameStats runUntilFinished(Runner& runner, taskrunner::clock::VirtualClock& clock, int max_frames) {
+	FrameStats stats;
+	while (runner.getTaskQueueCount() > 0 && stats.frames < max_frames) {
+		runFrame(runner, clock, stats);
+	}
+	return stats;
+}
+
+static void printHeader() {
+	std::printf("%-14s %-22s %14s %14s %14s  %s\n", "benchmark", "case", "avg us/frame", "max us/frame", "allocs/frame", "note");
+}
+
+static void printRow(const char* name, const std::string& label, const FrameStats& stats, const std::string& note = "") {
+	std::printf("%-14s %-22s %14.2f %14llu %14.2f  %s\n", name, label.c_str(),
+		stats.avgMicros(), (unsigned long long)stats.max_micros, stats.avgAllocations(), note.c_str());
+}
+
+static std::string formatMicros(const char* what, double micros) {
+	char buffer[64];
+	std::snprintf(buffer, sizeof(buffer), "%s %.3f us", what, micros);
+	return buffer;
+}
+
+static std::string formatCount(const char* what, double count) {
+	char buffer[64];
+	std::snprintf(buffer, sizeof(buffer), "%s %.2f", what, count);
+	return buffer;
+}
+
+//--------------------------------------------------------------
+/// many queues sleeping on a long wait (like cue queues on installations) + active queues
+static void benchIdleQueues(size_t num_idle_queues, size_t num_active_queues, int num_frames) {
+	BenchApp app;
+	taskrunner::clock::VirtualClock clock;
+	Runner runner;
+	runner.setClock(clock);
+	runner.setup(app);
+
+	for (size_t i = 0; i < num_idle_queues; i++) {
+		runner.createTaskQueue("idle")
+			.wait_sec(3600.0)
+			.then([](BenchApp& self){
+				self.counter++;
+			});
+	}
+
+	// something becomes due on every frame
+	for (size_t i = 0; i < num_active_queues; i++) {
+		auto& task_queue = runner.createTaskQueue("active");
+		for (int frame = 0; frame < num_frames; frame++) {
+			double scale = 1.0 + i;
+			double offset = 0.5 * frame;
+			task_queue
+				.wait_sec(FRAME_SEC)
+				.then([i, frame, scale, offset](BenchApp& self){
+					self.counter += i + frame + (size_t)(scale + offset);
+				})
+				.then_on_draw([i, frame, scale, offset](const BenchApp& self){
+					(void)self;
+				});
+		}
+	}
+
+	// first frame processes all newly created queues once (not measured)
+	FrameStats warmup;
+	runFrame(runner, clock, warmup);
+
+	FrameStats stats;
+	for (int frame = 0; frame < num_frames; frame++) {
+		runFrame(runner, clock, stats);
+	}
+
+	printRow("idle_queues", std::to_string(num_idle_queues) + " idle", stats, std::to_string(num_active_queues) + " active");
+}
+
+//--------------------------------------------------------------
+/// many waits expiring on the same frame (e.g. cue queues started together)
+static void benchMassExpiry(size_t num_queues, size_t num_idle_queues) {
+	BenchApp app;
+	taskrunner::clock::VirtualClock clock;
+	Runner runner;
+	runner.setClock(clock);
+	runner.setup(app);
+
+	for (size_t i = 0; i < num_idle_queues; i++) {
+		runner.createTaskQueue().wait_sec(3600.0);
+	}
+	for (size_t i = 0; i < num_queues; i++) {
+		runner.createTaskQueue()
+			.wait_sec(FRAME_SEC * 2)
+			.wait_sec(3600.0);
+	}
+
+	// first frame processes all newly created queues once (not measured)
+	FrameStats warmup;
+	runFrame(runner, clock, warmup);
+
+	// all waits expire on the second frame
+	FrameStats stats;
+	runFrame(runner, clock, stats);
+	runFrame(runner, clock, stats);
+
+	printRow("mass_expiry", std::to_string(num_queues) + " due at once", stats,
+		std::to_string(num_idle_queues) + " idle, " + formatMicros("per queue", stats.total_micros / (double)num_queues));
+}
+
+//--------------------------------------------------------------
+/// queues looping their own steps by loop() (callbacks capture 32 bytes, so they fit inline)
+static void benchQueueLoop(size_t num_queues, int num_frames) {
+	BenchApp app;
+	taskrunner::clock::VirtualClock clock;
+	Runner runner;
+	runner.setClock(clock);
+	runner.setup(app);
+
+	std::array<char, 32> capture {};
+	size_t allocations_before = allocation_count;
+	for (size_t i = 0; i < num_queues; i++) {
+		runner.createTaskQueue()
+			.wait_sec(FRAME_SEC)
+			.then([capture](BenchApp& self){
+				self.counter += capture[0] + 1;
+			})
+			.then_on_draw([capture](const BenchApp& self){
+				(void)self;
+				(void)capture;
+			})
+			.loop();
+	}
+	// (steps are moved into a program by loop(): per queue, not per step)
+	double build_allocations = (allocation_count - allocations_before) / (double)num_queues;
+
+	// first frame processes all newly created queues once (not measured)
+	FrameStats warmup;
+	runFrame(runner, clock, warmup);
+
+	FrameStats stats;
+	for (int frame = 0; frame < num_frames; frame++) {
+		runFrame(runner, clock, stats);
+	}
+
+	printRow("queue_loop", std::to_string(num_queues) + " queues", stats,
+		formatCount("build allocs/queue", build_allocations));
+}
+
+//--------------------------------------------------------------
+/// many queues with staggered deadlines (a few of them due on each frame, the rest waiting)
+static void benchStaggered(size_t num_queues, int num_frames) {
+	BenchApp app;
+	taskrunner::clock::VirtualClock clock;
+	Runner runner;
+	runner.setClock(clock);
+	runner.setup(app);
+
+	// queue i becomes due on frame (i % num_frames) + 1, then waits for an hour
+	for (size_t i = 0; i < num_queues; i++) {
+		runner.createTaskQueue()
+			.wait_sec(FRAME_SEC * (i % num_frames + 0.5))
+			.then([](BenchApp& self){
+				self.counter++;
+			})
+			.wait_sec(3600.0);
+	}
+
+	// first frame processes all newly created queues once (not measured)
+	FrameStats warmup;
+	runFrame(runner, clock, warmup);
+
+	size_t due_before = app.counter;
+	FrameStats stats;
+	for (int frame = 0; frame < num_frames; frame++) {
+		runFrame(runner, clock, stats);
+	}
+	double num_due = (double)(app.counter - due_before);
+
+	printRow("staggered", std::to_string(num_queues) + " queues", stats,
+		formatCount("due/frame", num_due / num_frames) + ", " + formatMicros("per due queue", stats.total_micros / num_due));
+}
+
+//--------------------------------------------------------------
+/// update / draw callbacks capturing CaptureBytes each (inline up to 48 bytes, heap above)
+template <size_t CaptureBytes>
+static void benchCallbacks(size_t num_queues, int num_frames) {
+	BenchApp app;
+	taskrunner::clock::VirtualClock clock;
+	Runner runner;
+	runner.setClock(clock);
+	runner.setup(app);
+
+	std::array<char, CaptureBytes> capture {};
+	size_t allocations_before = allocation_count;
+	for (size_t i = 0; i < num_queues; i++) {
+		auto& task_queue = runner.createTaskQueue();
+		for (int frame = 0; frame < num_frames; frame++) {
+			task_queue
+				.wait_sec(FRAME_SEC)
+				.then([capture](BenchApp& self){
+					self.counter += capture[0] + 1;
+				})
+				.then_on_draw([capture](const BenchApp& self){
+					(void)self;
+					(void)capture;
+				});
+		}
+	}
+	double build_allocations = (allocation_count - allocations_before) / (double)(num_queues * num_frames);
+
+	// first frame processes all newly created queues once (not measured)
+	FrameStats warmup;
+	runFrame(runner, clock, warmup);
+
+	FrameStats stats;
+	for (int frame = 0; frame < num_frames; frame++) {
+		runFrame(runner, clock, stats);
+	}
+
+	printRow("callbacks", std::to_string(CaptureBytes) + " byte captures", stats,
+		std::to_string(num_queues) + " queues, " + formatCount("build allocs/step", build_allocations));
+}
+
+//--------------------------------------------------------------
+/// queues with long chains (wait, then_on_update, then_on_draw per step)
+static void benchChainLength(size_t num_queues, int chain_length) {
+	BenchApp app;
+	taskrunner::clock::VirtualClock clock;
+	Runner runner;
+	runner.setClock(clock);
+	runner.setup(app);
+
+	auto build_started = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < num_queues; i++) {
+		auto& task_queue = runner.createTaskQueue();
+		for (int step = 0; step < chain_length; step++) {
+			task_queue
+				.wait_sec(FRAME_SEC)
+				.then([step](BenchApp& self){
+					self.counter += step;
+				})
+				.then_on_draw([](const BenchApp& self){
+					(void)self;
+				});
+		}
+	}
+	auto build_elapsed = std::chrono::steady_clock::now() - build_started;
+	double build_micros = std::chrono::duration_cast<std::chrono::nanoseconds>(build_elapsed).count() / 1000.0;
+
+	FrameStats stats = runUntilFinished(runner, clock, chain_length * 2 + 10);
+
+	printRow("chain_length", std::to_string(num_queues) + " x " + std::to_string(chain_length) + " steps", stats,
+		formatMicros("build/step", build_micros / (num_queues * chain_length)));
+}
+
+//--------------------------------------------------------------
+/// same chain as benchChainLength, built once as TaskProgram and instantiated per queue
+static void benchProgram(size_t num_queues, int chain_length) {
+	BenchApp app;
+	taskrunner::clock::VirtualClock clock;
+	Runner runner;
+	runner.setClock(clock);
+	runner.setup(app);
+
+	TaskProgram<BenchApp> builder;
+	for (int step = 0; step < chain_length; step++) {
+		builder
+			.wait_sec(FRAME_SEC)
+			.then([step](BenchApp& self, int param){
+				self.counter += step + param;
+			})
+			.then_on_draw([](BenchApp& self, int param){
+				(void)self;
+				(void)param;
+			});
+	}
+	TaskProgramRef<BenchApp> program = builder.build();
+
+	auto build_started = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < num_queues; i++) {
+		runner.createTaskQueue().then_program(program, (int)i);
+	}
+	auto build_elapsed = std::chrono::steady_clock::now() - build_started;
+	double build_micros = std::chrono::duration_cast<std::chrono::nanoseconds>(build_elapsed).count() / 1000.0;
+
+	FrameStats stats = runUntilFinished(runner, clock, chain_length * 2 + 10);
+
+	printRow("program", std::to_string(num_queues) + " x " + std::to_string(chain_length) + " steps", stats,
+		formatMicros("instantiate", build_micros / num_queues));
+}
+
+//--------------------------------------------------------------
+/// groups of queues repeatedly waiting on each other (wait_sync_sec with different durations)
+static void benchSyncWait(int num_groups, int num_members, int num_waits) {
+	BenchApp app;
+	taskrunner::clock::VirtualClock clock;
+	taskrunner::sync::SyncGroups sync_groups;
+	Runner runner;
+	runner.setClock(clock);
+	runner.setSyncGroups(sync_groups);
+	runner.setup(app);
+
+	for (int member = 0; member < num_members; member++) {
+		runner.registerTaskId(member + 1);
+	}
+
+	for (int group = 0; group < num_groups; group++) {
+		std::string name = "group_" + std::to_string(group);
+		for (int member = 0; member < num_members; member++) {
+			auto& task_queue = runner.createTaskQueue(member + 1, name);
+			for (int i = 0; i < num_waits; i++) {
+				task_queue
+					.wait_sync_sec(FRAME_SEC * (1 + (member + i) % 4))
+					.then([](BenchApp& self){
+						self.counter++;
+					});
+			}
+		}
+	}
+
+	FrameStats stats = runUntilFinished(runner, clock, num_waits * 8 + 10);
+
+	double releases = (double)num_groups * num_waits;
+	printRow("sync_wait", std::to_string(num_groups) + " x " + std::to_string(num_members) + " members", stats,
+		formatMicros("per release", stats.total_micros / releases));
+}
+
+//--------------------------------------------------------------
+/// many parameters animated at once by tween() steps (evaluated in one batch per frame)
+static void benchTween(size_t num_tweens, int num_frames) {
+	BenchApp app;
+	taskrunner::clock::VirtualClock clock;
+	Runner runner;
+	runner.setClock(clock);
+	runner.setup(app);
+
+	std::vector<float> values(num_tweens);
+	for (size_t i = 0; i < num_tweens; i++) {
+		auto easing = static_cast<taskrunner::tween::Easing>(i % taskrunner::tween::easing_count);
+		runner.createTaskQueue()
+			.tween(FRAME_SEC * num_frames * 2, &values[i], 0.0f, 1.0f, easing);
+	}
+
+	// first frame starts all tweens (not measured)
+	FrameStats warmup;
+	runFrame(runner, clock, warmup);
+
+	FrameStats stats;
+	for (int frame = 0; frame < num_frames; frame++) {
+		runFrame(runner, clock, stats);
+	}
+
+	printRow("tween", std::to_string(num_tweens) + " tweens", stats,
+		formatMicros("per tween", stats.avgMicros() / num_tweens));
+}
+
+//--------------------------------------------------------------
+/// short-lived queues created on every frame (creation + reclamation)
+static void benchSpawn(size_t queues_per_frame, int num_frames, bool use_pool = false) {
+	BenchApp app;
+	taskrunner::clock::VirtualClock clock;
+	Runner runner;
+#ifdef OFX_TASKRUNNER_PMR
+	// steps of reclaimed queues are reused by the pool (no heap allocation in steady state)
+	std::pmr::unsynchronized_pool_resource pool;
+	if (use_pool) {
+		runner.setMemoryResource(pool);
+	}
+#endif
+	runner.setClock(clock);
+	runner.setup(app);
+
+	FrameStats stats;
+	uint64_t spawn_nanos = 0;
+	size_t spawn_allocations = 0;
+	for (int frame = 0; frame < num_frames; frame++) {
+		size_t allocations_before = allocation_count;
+		auto started = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < queues_per_frame; i++) {
+			runner.createTaskQueue().then([](BenchApp& self){
+				self.counter++;
+			});
+		}
+		spawn_nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count();
+		spawn_allocations += allocation_count - allocations_before;
+
+		runFrame(runner, clock, stats);
+	}
+
+	printRow(use_pool ? "spawn_pool" : "spawn", std::to_string(queues_per_frame) + " queues/frame", stats,
+		formatMicros("create/queue", spawn_nanos / 1000.0 / (queues_per_frame * num_frames))
+		+ formatCount(", allocs/queue", spawn_allocations / (double)(queues_per_frame * num_frames)));
+}
+
+//--------------------------------------------------------------
+/// add a then_all() tree: each level joins fan_out children (leaves count up)
+static void addJoinTree(TaskQueue<BenchApp>& task_queue, int fan_out, int depth) {
+	if (depth == 0) {
+		task_queue.then([](BenchApp& self){
+			self.counter++;
+		});
+		return;
+	}
+	std::vector<CreateTaskQueueFunction<BenchApp>> children;
+	for (int i = 0; i < fan_out; i++) {
+		children.push_back([fan_out, depth](TaskQueue<BenchApp>& child){
+			addJoinTree(child, fan_out, depth - 1);
+		});
+	}
+	task_queue.then_all(std::move(children));
+}
+
+/// nested fork / join (children start and parents resume on the same frame, so a tree finishes in one frame)
+static void benchJoin(int fan_out, int depth, int num_trees) {
+	BenchApp app;
+	taskrunner::clock::VirtualClock clock;
+	Runner runner;
+	runner.setClock(clock);
+	runner.setup(app);
+
+	for (int i = 0; i < num_trees; i++) {
+		addJoinTree(runner.createTaskQueue(), fan_out, depth);
+	}
+	FrameStats stats = runUntilFinished(runner, clock, 1000);
+
+	size_t num_queues = 0;
+	for (int level = 0, width = 1; level <= depth; level++, width *= fan_out) {
+		num_queues += width;
+	}
+	printRow("join", std::to_string(num_trees) + " x " + std::to_string(fan_out) + "^" + std::to_string(depth), stats,
+		std::to_string(stats.frames) + " frames, " + formatMicros("per queue", stats.total_micros / (double)(num_queues * num_trees)));
+}
+
+//--------------------------------------------------------------
+/// layered dependency graph (each node waits one frame, and depends on 2 nodes of the previous layer)
+static void benchGraph(int num_layers, int width) {
+	BenchApp app;
+	taskrunner::clock::VirtualClock clock;
+	Runner runner;
+	runner.setClock(clock);
+	runner.setup(app);
+
+	auto program = TaskProgram<BenchApp>()
+		.wait_sec(FRAME_SEC)
+		.then([](BenchApp& self, int){
+			self.counter++;
+		})
+		.build();
+
+	auto build_started = std::chrono::steady_clock::now();
+	TaskGraph<BenchApp> graph;
+	for (int layer = 0; layer < num_layers; layer++) {
+		for (int i = 0; i < width; i++) {
+			auto node = graph.node("node", program);
+			if (layer > 0) {
+				// same column and next column of the previous layer
+				auto above = node - width;
+				graph.after(node, { above, above - i + (i + 1) % width });
+			}
+		}
+	}
+	auto graph_ref = graph.build();
+	double build_micros = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - build_started).count() / 1000.0;
+
+	runner.runGraph(graph_ref);
+	FrameStats stats = runUntilFinished(runner, clock, num_layers * 4);
+
+	printRow("graph", std::to_string(num_layers) + " x " + std::to_string(width) + " nodes", stats,
+		std::to_string(stats.frames) + " frames, " + formatMicros("build/node", build_micros / (num_layers * width)));
+}
+
+//--------------------------------------------------------------
+/// many looping queues due on every frame, advanced serially or on worker threads (callbacks still run in order)
+static void benchParallel(size_t num_queues, int num_frames, size_t thread_count) {
+	BenchApp app;
+	taskrunner::clock::VirtualClock clock;
+	Runner runner;
+	runner.setClock(clock);
+	runner.setup(app);
+	runner.setParallelThreadCount(thread_count);
+
+	auto program = TaskProgram<BenchApp>()
+		.wait_sec(FRAME_SEC)
+		.then([](BenchApp& self, int){
+			self.counter++;
+		})
+		.loop()
+		.build();
+	for (size_t i = 0; i < num_queues; i++) {
+		runner.createTaskQueue().drift_free().then_program(program);
+	}
+
+	FrameStats warmup;
+	runFrame(runner, clock, warmup);
+
+	FrameStats stats;
+	for (int frame = 0; frame < num_frames; frame++) {
+		runFrame(runner, clock, stats);
+	}
+
+	printRow("parallel", std::to_string(num_queues) + " queues", stats,
+		std::to_string(thread_count) + " threads, " + formatMicros("per queue", stats.avgMicros() / num_queues));
+}
+
+//========================================================================
+int main(int argc, char** argv) {
+	bool quick = false;
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--quick") == 0) {
+			quick = true;
+		} else {
+			std::fprintf(stderr, "usage: %s [--quick]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	const int num_frames = quick ? 30 : 120;
+
+	printHeader();
+
+	std::vector<size_t> idle_counts = quick ? std::vector<size_t> { 1000, 100000 } : std::vector<size_t> { 1000, 100000, 1000000 };
+	for (size_t num_idle_queues : idle_counts) {
+		benchIdleQueues(num_idle_queues, 100, num_frames);
+	}
+
+	for (size_t num_queues : { 1000, 100000 }) {
+		benchMassExpiry(num_queues, 100000);
+	}
+
+	benchQueueLoop(quick ? 100 : 1000, num_frames);
+
+	std::vector<size_t> staggered_counts = quick ? std::vector<size_t> { 10000, 100000 } : std::vector<size_t> { 10000, 1000000 };
+	for (size_t num_queues : staggered_counts) {
+		benchStaggered(num_queues, num_frames);
+	}
+
+	benchCallbacks<32>(100, num_frames);
+	benchCallbacks<64>(100, num_frames);
+
+	for (int chain_length : { 1, 10, 100 }) {
+		benchChainLength(quick ? 100 : 1000, chain_length);
+	}
+
+	for (int chain_length : { 10, 100 }) {
+		benchProgram(quick ? 100 : 1000, chain_length);
+	}
+
+	benchSyncWait(10, 10, quick ? 10 : 60);
+	benchSyncWait(100, 100, quick ? 5 : 30);
+
+	for (size_t num_tweens : { 1000, 100000 }) {
+		benchTween(num_tweens, num_frames);
+	}
+
+	benchSpawn(quick ? 100 : 1000, num_frames);
+#ifdef OFX_TASKRUNNER_PMR
+	benchSpawn(quick ? 100 : 1000, num_frames, true);
+#endif
+
+	benchJoin(4, 4, quick ? 10 : 100);
+
+	benchGraph(quick ? 20 : 100, quick ? 100 : 1000);
+
+	// (workers + the main thread use all cores)
+	size_t parallel_threads = std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 0;
+	benchParallel(100000, num_frames, 0);
+	if (parallel_threads > 0) {
+		benchParallel(100000, num_frames, parallel_threads);
+	}
+
+	return 0;
+}
@@ -11,7 +11,7 @@ void ofApp::setup(){
 
 	taskRunner.setup(*this);
 
-	// Create a simple task queue that changes background color in 5 stages
+	// Create a simple task queue that changes background color in 5 stages (looped)
 	taskRunner.createTaskQueue()
 		.wait_sec(1.0)
 		.then([this](ofApp& self){
@@ -42,7 +42,8 @@ void ofApp::setup(){
 		.then([this](ofApp& self){
 			// Return to black (end of cycle)
 			backgroundColor = ofColor(0, 0, 0);
-		});
+		})
+		.loop(); // Repeat the cycle forever (steps are reused, not rebuilt)
 }
 
 //--------------------------------------------------------------
@@ -30,38 +30,43 @@ void ofApp::setup(){
 		taskRunner.registerTaskId(task_ids[i]);
 	}
 	
+	// Build the sequence once (steps are shared by all tasks)
+	// taskIndex is given to each instance by then_program()
+	TaskProgram<ofApp> program;
+	program
+		.wait_sync_sec(1.0) // Wait 1 second (synchronized)
+		.then([](ofApp& self, int taskIndex){
+			// Start displaying with small size
+			self.taskParams[taskIndex].visible = true;
+			self.taskParams[taskIndex].size = 50;
+		})
+		.wait_sync_sec(1.0) // Wait 1 second (synchronized)
+		.then([](ofApp& self, int taskIndex){
+			// Set to medium size
+			self.taskParams[taskIndex].size = 100;
+		})
+		.wait_sync_sec(1.0) // Wait 1 second (synchronized)
+		.then([](ofApp& self, int taskIndex){
+			// Set to large size
+			self.taskParams[taskIndex].size = 150;
+		})
+		.wait_sync_sec(1.0) // Wait 1 second (synchronized)
+		.then([](ofApp& self, int taskIndex){
+			// Return to small size
+			self.taskParams[taskIndex].size = 50;
+		})
+		.wait_sync_sec(1.0) // Wait 1 second (synchronized)
+		.then([](ofApp& self, int taskIndex){
+			// Hide (end of animation)
+			self.taskParams[taskIndex].visible = false;
+		});
+
+	TaskProgramRef<ofApp> sequence = program.build();
+
 	// Create each task
 	for(int i = 0; i < NUM_TASKS; i++) {
-		int taskIndex = i; // Variable for capture
-
-		
 		taskRunner.createTaskQueue(task_ids[i], "sync_task")
-			.wait_sync_sec(1.0) // Wait 1 second (synchronized)
-			.then([taskIndex](ofApp& self){
-				// Start displaying with small size
-				self.taskParams[taskIndex].visible = true;
-				self.taskParams[taskIndex].size = 50;
-			})
-			.wait_sync_sec(1.0) // Wait 1 second (synchronized)
-			.then([taskIndex](ofApp& self){
-				// Set to medium size
-				self.taskParams[taskIndex].size = 100;
-			})
-			.wait_sync_sec(1.0) // Wait 1 second (synchronized)
-			.then([taskIndex](ofApp& self){
-				// Set to large size
-				self.taskParams[taskIndex].size = 150;
-			})
-			.wait_sync_sec(1.0) // Wait 1 second (synchronized)
-			.then([taskIndex](ofApp& self){
-				// Return to small size
-				self.taskParams[taskIndex].size = 50;
-			})
-			.wait_sync_sec(1.0) // Wait 1 second (synchronized)
-			.then([taskIndex](ofApp& self){
-				// Hide (end of animation)
-				self.taskParams[taskIndex].visible = false;
-			});
+			.then_program(sequence, i);
 	}
 }
 
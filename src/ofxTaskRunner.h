@@ -1,11 +1,72 @@
 #pragma once 
 
+// define OFX_TASKRUNNER_HEADLESS to use the scheduler without openFrameworks
+// (e.g. benchmark/). openFrameworks is only used through taskrunner::adapter
+#ifndef OFX_TASKRUNNER_HEADLESS
 #include "ofMain.h"
+#endif
 
-#include <random>
 #include <sstream>
-#include "boost/optional.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <functional>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <array>
+#include <queue>
+#include <unordered_map>
+#include <thread>
+#include <fstream>
+#include <utility>
+#include <cstring>
+#include <cerrno>
+
+// cross-process sync groups (taskrunner::sync::SharedMemorySyncGroups) need POSIX shared memory
+#if defined(__unix__) || defined(__APPLE__)
+#define OFX_TASKRUNNER_SHARED_MEMORY_SYNC
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(OFX_TASKRUNNER_HEADLESS) && __cplusplus >= 201703L
+#include <optional>
+#else
+#include "boost/optional.hpp"
+#endif
+
+// per-queue step storage from a std::pmr::memory_resource (see ofxTaskRunner::setMemoryResource()). only when
+// the standard library provides it for the deployment target: libc++ ships <memory_resource> but its symbols are
+// unavailable before macOS 14 / iOS 17. define OFX_TASKRUNNER_NO_PMR to turn it off anyway
+#ifndef OFX_TASKRUNNER_NO_PMR
+#if defined(__ENVIRONMENT_MAC_OS_X_VERSION_MIN_REQUIRED__) && __ENVIRONMENT_MAC_OS_X_VERSION_MIN_REQUIRED__ < 140000
+#define OFX_TASKRUNNER_NO_PMR
+#elif defined(__ENVIRONMENT_IPHONE_OS_VERSION_MIN_REQUIRED__) && __ENVIRONMENT_IPHONE_OS_VERSION_MIN_REQUIRED__ < 170000
+#define OFX_TASKRUNNER_NO_PMR
+#endif
+#endif
+#if __cplusplus >= 201703L && defined(__has_include) && !defined(OFX_TASKRUNNER_NO_PMR)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#if defined(__cpp_lib_memory_resource)
+#define OFX_TASKRUNNER_PMR
+#endif
+#endif
+#endif
 
 // ===============================================
 
@@ -13,57 +74,60 @@ namespace taskrunner {
 
 namespace optional {
 
+#if defined(OFX_TASKRUNNER_HEADLESS) && __cplusplus >= 201703L
+    template <class T>
+    using optional = std::optional<T>;
+
+    static constexpr std::nullopt_t none = std::nullopt;
+#else
     template <class T>
     using optional = boost::optional<T>;
 
     static boost::none_t none = boost::none;
+#endif
 
     template <class T>
     using optional_ref = optional<std::reference_wrapper<T>>;
 
 } // namespace optional
 
-namespace uuid {
+namespace adapter {
 
-    static std::random_device              rd;
-    static std::mt19937                    gen(rd());
-    static std::uniform_int_distribution<> dis(0, 15);
-    static std::uniform_int_distribution<> dis2(8, 11);
+#ifdef OFX_TASKRUNNER_HEADLESS
+    /// error log to std::cerr (same format as ofLogError)
+    class LogError {
+    private:
+        std::ostringstream message;
 
-    inline std::string generate_uuid_v4() {
-        std::stringstream ss;
-        int i;
-        ss << std::hex;
-        for (i = 0; i < 8; i++) {
-            ss << dis(gen);
-        }
-        ss << "-";
-        for (i = 0; i < 4; i++) {
-            ss << dis(gen);
+    public:
+        LogError(const std::string& module = "") {
+            message << "[error] ";
+            if (!module.empty()) {
+                message << module << ": ";
+            }
         }
-        ss << "-4";
-        for (i = 0; i < 3; i++) {
-            ss << dis(gen);
+
+        ~LogError() {
+            std::cerr << message.str() << std::endl;
         }
-        ss << "-";
-        ss << dis2(gen);
-        for (i = 0; i < 3; i++) {
-            ss << dis(gen);
+
+        template <class T>
+        LogError& operator<<(const T& value) {
+            message << value;
+            return *this;
         }
-        ss << "-";
-        for (i = 0; i < 12; i++) {
-            ss << dis(gen);
-        };
-        return ss.str();
-    }
+    };
+#else
+    using LogError = ofLogError;
+#endif
 
-} // namespace uuid
+} // namespace adapter
 
 namespace utils {
 
     [[noreturn]] inline void __unreachable(const char* file, int line)
     {
-        ofLogError() << "unreachable! (" << file << ":" << line << ")";
+        taskrunner::adapter::LogError() << "unreachable! (" << file << ":" << line << ")";
         // Uses compiler specific extensions if possible.
         // Even if no extension is used, undefined behavior is still raised by
         // an empty function body and the noreturn attribute.
@@ -79,7 +143,7 @@ namespace utils {
 
     [[noreturn]] inline void __unimplemented(const char* file, int line)
     {
-        ofLogError() << "unimplemented! (" << file << ":" << line << ")";
+        taskrunner::adapter::LogError() << "unimplemented! (" << file << ":" << line << ")";
         // Uses compiler specific extensions if possible.
         // Even if no extension is used, undefined behavior is still raised by
         // an empty function body and the noreturn attribute.
@@ -95,8 +159,9 @@ namespace utils {
 
     [[noreturn]] inline void __panic(const char* file, int line)
     {
-        ofLogError() << "panic! (" << file << ":" << line << ")";
+        taskrunner::adapter::LogError() << "panic! (" << file << ":" << line << ")";
         assert(false);
+        std::abort();
     }
 
     // to show original file and line number
@@ -104,447 +169,4783 @@ namespace utils {
 
 } // namespace utils
 
-namespace container {
-
-    template<class T>
-    class queue : public std::queue<T>
-    {
-    public:
-        void clear()
-        {
-            std::queue<T> empty;
-            std::swap(empty, *this);
-        }
-    };
-
-} // namespace container
-
-} // namespace taskrunner
-
-// ===============================================
+namespace clock {
 
-enum class TaskType {
-    WAIT,
-    DRAW,
-    UPDATE,
-    CREATE_TASK_QUEUE,
-};
+    /// time in nanoseconds
+    using nanoseconds = int64_t;
 
-class TaskId {
-private:
-    size_t uuid;
-    static size_t uuid_counter;
-    void setUuid() {
-        // check max
-        if (uuid_counter >= std::numeric_limits<size_t>::max() - 1) {
-            uuid_counter = 0;
-        }
-        this->uuid = uuid_counter++;
+    inline nanoseconds fromSec(double sec) {
+        return static_cast<nanoseconds>(sec * 1e9);
     }
 
-public:
-    TaskId() {
-        this->setUuid();
-    }
-    size_t id() {
-        return this->uuid;
-    }
-    bool operator==(const TaskId& other) const {
-        return this->uuid == other.uuid;
+    inline nanoseconds fromMillis(double millis) {
+        return static_cast<nanoseconds>(millis * 1e6);
     }
-    bool operator!=(const TaskId& other) const {
-        return this->uuid != other.uuid;
-    }
-};
 
-class Task {
-private:
-    TaskId uuid;
-public:
-    Task() : uuid() {
-    }
-    virtual TaskType getTaskType() const = 0;
-    TaskId id() {
-        return this->uuid;
+    inline double toSec(nanoseconds ns) {
+        return ns / 1e9;
     }
-};
 
-class WaitTask : public Task {
-private:
-    float wait_time_sec;
-    float wait_started_timef;
-    bool need_sync;
-    int task_id;
-    std::string task_queue_name;
+    /// @brief time source of ofxTaskRunner (see ofxTaskRunner::setClock())
+    class Clock {
+    public:
+        virtual ~Clock() = default;
+        /// monotonic time in nanoseconds
+        virtual nanoseconds now() = 0;
+    };
 
-    static map<std::string, float> wait_started_timef_map_for_names;
-    static map<std::pair<int, std::string>, bool> done_map_for_name_and_task_id;
-    static vector<int> registered_task_ids;
-    static std::mutex sync_mutex;
+    /// monotonic clock (std::chrono::steady_clock), counted from construction
+    class SteadyClock : public Clock {
+    private:
+        std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
 
-public:
-    WaitTask(float wait_time_sec, bool need_sync, int task_id, std::string task_queue_name) {
-        this->wait_time_sec = wait_time_sec;
-        this->wait_started_timef = -9999.9f;
-        this->need_sync = need_sync;
-        this->task_id = task_id;
-        this->task_queue_name = task_queue_name;
-    }
+    public:
+        nanoseconds now() override {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count();
+        }
+    };
 
-    TaskType getTaskType() const override {
-        return TaskType::WAIT;
-    }
+    /// @brief clock which is advanced manually (for fast-forwarding timelines in tests etc.)
+    class VirtualClock : public Clock {
+    private:
+        nanoseconds time = 0;
 
-    /// @brief register task id at setup (need to detect all tasks are done for sync)
-    /// @param task_id 
-    static void registerTaskId(int task_id) {
-        if (std::find(registered_task_ids.begin(), registered_task_ids.end(), task_id) == registered_task_ids.end()) {
-            registered_task_ids.push_back(task_id);
+    public:
+        nanoseconds now() override {
+            return time;
         }
-    }
 
-    void start() {
-        if (this->need_sync) {
-            lock_guard<mutex> lock(sync_mutex);
-            if (wait_started_timef_map_for_names.count(this->task_queue_name) > 0) {
-                this->wait_started_timef = wait_started_timef_map_for_names.at(this->task_queue_name);
-            }else{
-                this->wait_started_timef = ofGetElapsedTimef();
-            }
-        }else{
-            this->wait_started_timef = ofGetElapsedTimef();
+        void set(nanoseconds time) {
+            this->time = time;
         }
-    }
-
-    bool isStarted() const {
-        return this->wait_started_timef > 0;
-    }
-
-    bool isDone() const {
-        bool bDone = ofGetElapsedTimef() - this->wait_started_timef >= this->wait_time_sec;
 
-        if (this->need_sync) {
-            if (bDone) {
-                lock_guard<mutex> lock(sync_mutex);
-                auto key = std::make_pair(this->task_id, this->task_queue_name);
-                done_map_for_name_and_task_id[key] = true;
-                
-                // if all tasks/screens are done, clean them (with task queue name)
-                bool all_done = true;
-                for (auto& task_id : registered_task_ids) {
-                    auto _key = std::make_pair(task_id, this->task_queue_name);
-                    if (done_map_for_name_and_task_id.count(_key) == 0) {
-                        all_done = false;
-                        break;
-                    }
-                }
+        void advance(nanoseconds duration) {
+            time += duration;
+        }
 
-                if (all_done) {
-                    // delete map item with task queue name
-                    for (auto& task_id : registered_task_ids) {
-                        auto _key = std::make_pair(task_id, this->task_queue_name);
-                        if (done_map_for_name_and_task_id.count(_key) > 0) {
-                            done_map_for_name_and_task_id.erase(_key);
-                        }
-                    }
-                }
-            }
+        void advanceSec(double sec) {
+            advance(fromSec(sec));
         }
 
-        return bDone;
-    }
-};
+        void advanceMillis(double millis) {
+            advance(fromMillis(millis));
+        }
+    };
 
-template <typename App>
-class DrawTask : public Task {
-public:
-    std::function<void(App&)> draw_task;
+} // namespace clock
 
-    DrawTask(std::function<void(App&)> draw_task) {
-        this->draw_task = draw_task;
-    }
+namespace functional {
 
-    TaskType getTaskType() const override {
-        return TaskType::DRAW;
-    }
-};
+    template <class Signature, size_t BufferSize = 48>
+    class unique_function;
 
-template <typename App>
-class UpdateTask : public Task {
-public:
-    std::function<void(App&)> update_task;
+    /// @brief move-only std::function alternative. callables which fit in BufferSize
+    /// (and are nothrow movable) are stored inline, so moving or creating them never allocates.
+    template <class R, class... Args, size_t BufferSize>
+    class unique_function<R(Args...), BufferSize>
+    {
+    private:
+        struct operations
+        {
+            R (*invoke)(void* storage, Args&&... args);
+            void (*move)(void* dst, void* src);
+            void (*destroy)(void* storage);
+        };
 
-    UpdateTask(std::function<void(App&)> update_task) {
-        this->update_task = update_task;
-    }
-    TaskType getTaskType() const override {
-        return TaskType::UPDATE;
-    }
-};
+        template <class F>
+        struct inline_operations
+        {
+            static R invoke(void* storage, Args&&... args) {
+                return (*static_cast<F*>(storage))(std::forward<Args>(args)...);
+            }
+            static void move(void* dst, void* src) {
+                new (dst) F(std::move(*static_cast<F*>(src)));
+                static_cast<F*>(src)->~F();
+            }
+            static void destroy(void* storage) {
+                static_cast<F*>(storage)->~F();
+            }
+            static const operations* get() {
+                static const operations ops = { &invoke, &move, &destroy };
+                return &ops;
+            }
+        };
 
-template <typename App>
-class TaskQueue;
+        /// too large for the buffer: stored on heap, buffer holds the pointer
+        template <class F>
+        struct heap_operations
+        {
+            static F*& pointer(void* storage) {
+                return *static_cast<F**>(storage);
+            }
+            static R invoke(void* storage, Args&&... args) {
+                return (*pointer(storage))(std::forward<Args>(args)...);
+            }
+            static void move(void* dst, void* src) {
+                new (dst) F*(pointer(src));
+            }
+            static void destroy(void* storage) {
+                delete pointer(storage);
+            }
+            static const operations* get() {
+                static const operations ops = { &invoke, &move, &destroy };
+                return &ops;
+            }
+        };
 
-template <typename App>
-class CreateTaskQueueTask : public Task {
-public:
-    std::function<void(TaskQueue<App>&)> func_for_new_task_queue;
-    int task_id;
-    std::string task_queue_name;
-    CreateTaskQueueTask(int task_id, std::string task_queue_name, std::function<void(TaskQueue<App>&)> func_for_new_task_queue) {
-        this->task_id = task_id;
-        this->task_queue_name = task_queue_name;
-        this->func_for_new_task_queue = func_for_new_task_queue;
-    }
-    TaskType getTaskType() const override {
-        return TaskType::CREATE_TASK_QUEUE;
-    }
-};
+        template <class F>
+        using fits_inline = std::integral_constant<bool,
+            sizeof(F) <= BufferSize
+            && alignof(F) <= alignof(std::max_align_t)
+            && std::is_nothrow_move_constructible<F>::value>;
 
-// ================================================
+        typename std::aligned_storage<BufferSize, alignof(std::max_align_t)>::type storage;
+        const operations* ops = nullptr;
 
-template <typename App>
-class TaskQueue {
-private:
-    taskrunner::container::queue<unique_ptr<Task>> tasks;
+        template <class F>
+        void init(F&& f, std::true_type) {
+            using T = typename std::decay<F>::type;
+            new (&storage) T(std::forward<F>(f));
+            ops = inline_operations<T>::get();
+        }
 
-public:
-    int task_id;
-    std::string task_queue_name;
+        template <class F>
+        void init(F&& f, std::false_type) {
+            using T = typename std::decay<F>::type;
+            new (&storage) T*(new T(std::forward<F>(f)));
+            ops = heap_operations<T>::get();
+        }
 
-    TaskQueue(int task_id, std::string task_queue_name) {
-        this->task_id = task_id;
-        this->task_queue_name = task_queue_name;
-    }
+        void reset() {
+            if (ops != nullptr) {
+                ops->destroy(&storage);
+                ops = nullptr;
+            }
+        }
 
-    TaskQueue(TaskQueue&&) = default;
-    TaskQueue& operator=(TaskQueue&&) = default;
+    public:
+        unique_function() = default;
+        unique_function(std::nullptr_t) {}
 
-    // to prevent copying unique_ptr
-    TaskQueue(const TaskQueue&) = delete;
-    TaskQueue& operator=(const TaskQueue&) = delete;
+        template <class F, class T = typename std::decay<F>::type,
+            class = typename std::enable_if<!std::is_same<T, unique_function>::value>::type>
+        unique_function(F&& f) {
+            init(std::forward<F>(f), fits_inline<T>());
+        }
 
-    size_t size() const {
-        return tasks.size();
-    }
+        unique_function(unique_function&& other) noexcept {
+            if (other.ops != nullptr) {
+                other.ops->move(&storage, &other.storage);
+                ops = other.ops;
+                other.ops = nullptr;
+            }
+        }
 
-    bool hasTasks() const {
-        return !tasks.empty();
-    }
+        unique_function& operator=(unique_function&& other) noexcept {
+            if (this != &other) {
+                reset();
+                if (other.ops != nullptr) {
+                    other.ops->move(&storage, &other.storage);
+                    ops = other.ops;
+                    other.ops = nullptr;
+                }
+            }
+            return *this;
+        }
 
-    template <typename T>
-    T& front() {
-        return static_cast<T&>(*tasks.front());
-    }
+        unique_function(const unique_function&) = delete;
+        unique_function& operator=(const unique_function&) = delete;
 
-    void pop_front() {
-        if (tasks.empty()) {
-            return;
+        ~unique_function() {
+            reset();
         }
-        tasks.pop();
-    }
 
-    taskrunner::optional::optional<TaskType> getFirstTaskType() const {
-        if (tasks.empty()) {
-            return taskrunner::optional::none;
+        explicit operator bool() const {
+            return ops != nullptr;
         }
-        return tasks.front()->getTaskType();
-    }
 
-    /// add wait task (in seconds)
-    TaskQueue<App>& wait_sec(float wait_time_sec, bool need_sync = false) {
-        bool is_first_task = tasks.empty();
-        tasks.push(std::move(make_unique<WaitTask>(wait_time_sec, need_sync, task_id, task_queue_name)));
-        if (is_first_task) {
-            WaitTask& wait_task = static_cast<WaitTask&>(*tasks.front());
-            wait_task.start();
+        R operator()(Args... args) const {
+            return ops->invoke(const_cast<void*>(static_cast<const void*>(&storage)), std::forward<Args>(args)...);
         }
-        return *this;
-    }
+    };
 
-    /// add wait task (in milliseconds)
-    TaskQueue<App>& wait_ms(float wait_time_millis, bool need_sync = false) {
-        return wait_sec(wait_time_millis / 1000.0f, need_sync);
-    }
+} // namespace functional
 
-    /// add sync wait task (in seconds)
-    TaskQueue<App>& wait_sync_sec(float wait_time_sec) {
-        return wait_sec(wait_time_sec, true);
-    }
+namespace memory {
 
-    /// add sync wait task (in milliseconds)
-    TaskQueue<App>& wait_sync_ms(float wait_time_millis) {
-        return wait_ms(wait_time_millis, true);
-    }
+#ifdef OFX_TASKRUNNER_PMR
+    using memory_resource = std::pmr::memory_resource;
 
-    /// add draw task
-    TaskQueue<App>& then_on_draw(std::function<void(App&)> draw_task) {
-        tasks.push(std::move(make_unique<DrawTask<App>>(draw_task)));
-        return *this;
+    template <class T>
+    using vector = std::pmr::vector<T>;
+
+    inline memory_resource* defaultResource() {
+        return std::pmr::get_default_resource();
     }
 
-    /// add update task
-    TaskQueue<App>& then_on_update(std::function<void(App&)> update_task) {
-        tasks.push(std::move(make_unique<UpdateTask<App>>(update_task)));
-        return *this;
+    /// empty vector which allocates from resource (also after it was moved)
+    template <class T>
+    vector<T> makeVector(memory_resource* resource) {
+        return vector<T>(std::pmr::polymorphic_allocator<T>(resource));
     }
-    
-    /// add update task (alias)
-    TaskQueue<App>& then(std::function<void(App&)> update_task) {
-        return this->then_on_update(update_task);
+#else
+    /// (without std::pmr, everything comes from the global allocator)
+    struct memory_resource;
+
+    template <class T>
+    using vector = std::vector<T>;
+
+    inline memory_resource* defaultResource() {
+        return nullptr;
     }
 
-    /// add task which create new task queue
-    TaskQueue<App>& then_create_task_queue(std::string task_queue_name, std::function<void(TaskQueue<App>&)> func_for_new_task_queue) {
-        tasks.push(std::move(make_unique<CreateTaskQueueTask<App>>(task_id, task_queue_name, func_for_new_task_queue)));
-        return *this;
+    template <class T>
+    vector<T> makeVector(memory_resource*) {
+        return vector<T>();
     }
-};
+#endif
 
-// ================================================
-// ================================================
-// ================================================
+} // namespace memory
 
-template <typename App>
-class ofxTaskRunner {
-private:
-public:
-    void setup(App& app) {
-        this->_should_end = false;
+namespace container {
 
-        clearTaskQueues();
-        update_tasks.clear();
-        draw_tasks.clear();
-        create_task_queue_tasks.clear();
+    template<class T>
+    class queue : public std::queue<T>
+    {
+    public:
+        void clear()
+        {
+            std::queue<T> empty;
+            std::swap(empty, *this);
+        }
+    };
 
-        this->app = app;
-    }
+    template<class T, class Compare = std::less<T>>
+    class priority_queue : public std::priority_queue<T, std::vector<T>, Compare>
+    {
+    public:
+        void clear()
+        {
+            this->c.clear();
+        }
 
-    /// @brief register task id at setup (need to detect all tasks are done for sync)
-    /// @param task_id 
-    void registerTaskId(int task_id) {
-        WaitTask::registerTaskId(task_id);
-    }
+        size_t capacity() const
+        {
+            return this->c.capacity();
+        }
+    };
 
-    void clearTaskQueues() {
-        task_queues.clear();
-    }
+    /// @brief min-heap of (deadline, value) in structure-of-arrays (deadlines are packed for cache and SIMD).
+    /// 4-ary, so sift-down compares 4 adjacent deadlines per level and the tree is half as deep as a binary heap
+    template<class T>
+    class deadline_heap
+    {
+    private:
+        std::vector<clock::nanoseconds> times;
+        std::vector<T> values;
+        /// expired entries collected by compactExpired()
+        std::vector<std::pair<clock::nanoseconds, T>> expired;
 
-    void clear(){
-        clearTaskQueues();
-        update_tasks.clear();
-        draw_tasks.clear();
-        create_task_queue_tasks.clear();
-    }
+        static constexpr size_t arity = 4;
 
-    void processTaskQueue(TaskQueue<App>& task_queue) {
-        size_t task_count = task_queue.size();
+        /// index of the child with the earliest deadline (children of a full node are compared pairwise, without branches)
+        size_t minChild(size_t first_child, size_t count) const {
+            const clock::nanoseconds* t = times.data();
+            if (first_child + arity <= count) {
+                size_t a = t[first_child + 1] < t[first_child] ? first_child + 1 : first_child;
+                size_t b = t[first_child + 3] < t[first_child + 2] ? first_child + 3 : first_child + 2;
+                return t[b] < t[a] ? b : a;
+            }
+            size_t min_child = first_child;
+            for (size_t child = first_child + 1; child < count; child++) {
+                min_child = t[child] < t[min_child] ? child : min_child;
+            }
+            return min_child;
+        }
 
-        while (task_queue.hasTasks()) {
-            if (task_queue.getFirstTaskType() == TaskType::WAIT) {
-                WaitTask& wait_task = task_queue.template front<WaitTask>();
-                if (!wait_task.isStarted()) {
-                    wait_task.start();
-                    break;
-                }else if (wait_task.isDone()) {
-                    task_queue.pop_front();
-                }else {
+        void siftUp(size_t index, clock::nanoseconds time, T value) {
+            while (index > 0) {
+                size_t parent = (index - 1) / arity;
+                if (times[parent] <= time) {
                     break;
                 }
-            } else if (task_queue.getFirstTaskType() == TaskType::DRAW) {
-                DrawTask<App>& draw_task = task_queue.template front<DrawTask<App>>();
-                draw_tasks.push(draw_task.draw_task);
-                task_queue.pop_front();
-            } else if (task_queue.getFirstTaskType() == TaskType::UPDATE) {
-                UpdateTask<App>& update_task = task_queue.template front<UpdateTask<App>>();
-                update_tasks.push(update_task.update_task);
-                task_queue.pop_front();
-            } else if (task_queue.getFirstTaskType() == TaskType::CREATE_TASK_QUEUE) {
-                CreateTaskQueueTask<App>& create_task_queue_task = task_queue.template front<CreateTaskQueueTask<App>>();
-                create_task_queue_tasks.push(create_task_queue_task);
-                task_queue.pop_front();
+                times[index] = times[parent];
+                values[index] = values[parent];
+                index = parent;
             }
+            times[index] = time;
+            values[index] = value;
         }
 
-        bool going_to_next_task = task_queue.size() < task_count;
-
-        if (going_to_next_task && task_queue.hasTasks()) {
-            // check next task is wait task, if so, start it
-            if (task_queue.getFirstTaskType() == TaskType::WAIT) {
-                WaitTask& wait_task = task_queue.template front<WaitTask>();
-                if (!wait_task.isStarted()) {
-                    wait_task.start();
+        void siftDown(size_t index) {
+            size_t count = times.size();
+            clock::nanoseconds time = times[index];
+            T value = values[index];
+            while (index * arity + 1 < count) {
+                size_t min_child = minChild(index * arity + 1, count);
+                if (times[min_child] >= time) {
+                    break;
                 }
+                times[index] = times[min_child];
+                values[index] = values[min_child];
+                index = min_child;
             }
+            times[index] = time;
+            values[index] = value;
         }
-    }
 
-    void processTaskQueues(){
-        for (auto& task_queue : task_queues) {
-            processTaskQueue(task_queue);
+        /// restore the heap order of all entries in O(n)
+        void rebuild() {
+            size_t count = times.size();
+            if (count > 1) {
+                for (size_t i = (count - 2) / arity + 1; i-- > 0; ) {
+                    siftDown(i);
+                }
+            }
         }
 
-        std::remove_if(task_queues.begin(), task_queues.end(), [](const TaskQueue<App>& task_queue) {
-            return !task_queue.hasTasks();
-        });
-    }
+        /// @brief remove all entries with deadline <= now by one branch-free pass over the packed arrays,
+        /// and rebuild the heap in O(n). used when many entries expire at once (cheaper than popping each)
+        template<class F>
+        void compactExpired(clock::nanoseconds now, F&& on_expired) {
+            size_t count = times.size();
+            expired.resize(count);
+            size_t kept = 0;
+            size_t expired_count = 0;
+            for (size_t i = 0; i < count; i++) {
+                clock::nanoseconds time = times[i];
+                T value = values[i];
+                bool is_expired = time <= now;
+                times[kept] = time;
+                values[kept] = value;
+                expired[expired_count] = std::make_pair(time, value);
+                kept += is_expired ? 0 : 1;
+                expired_count += is_expired ? 1 : 0;
+            }
+            times.resize(kept);
+            values.resize(kept);
+            rebuild();
 
-    void update() {
-        if (!app) {
-            ofLogError("ofxTaskRunner") << "setup() must be called before update()";
-            taskrunner::utils::panic();
+            // in deadline order (same as popping)
+            std::sort(expired.begin(), expired.begin() + expired_count, [](const std::pair<clock::nanoseconds, T>& a, const std::pair<clock::nanoseconds, T>& b) {
+                return a.first < b.first;
+            });
+            for (size_t i = 0; i < expired_count; i++) {
+                on_expired(expired[i].second);
+            }
         }
 
-        processTaskQueues();
+    public:
+        void push(clock::nanoseconds time, T value) {
+            times.push_back(time);
+            values.push_back(value);
+            siftUp(times.size() - 1, time, value);
+        }
 
-        while (!update_tasks.empty()) {
-            auto task = update_tasks.front();
-            update_tasks.pop();
-            task(*app);
+        bool empty() const {
+            return times.empty();
         }
 
-        while (!create_task_queue_tasks.empty()) {
-            auto& t = create_task_queue_tasks.front();
-            create_task_queue_tasks.pop();
+        size_t size() const {
+            return times.size();
+        }
 
-            auto&& new_task_queue = createTaskQueue(t.task_id, t.task_queue_name);
-            t.func_for_new_task_queue(new_task_queue);
+        clock::nanoseconds top_time() const {
+            return times.front();
+        }
+
+        const T& top() const {
+            return values.front();
+        }
+
+        /// moves the hole at the root down to a leaf, then the last entry up from there
+        /// (the last entry mostly belongs near the bottom, so this compares less than sifting it down)
+        void pop() {
+            clock::nanoseconds last_time = times.back();
+            T last_value = values.back();
+            times.pop_back();
+            values.pop_back();
+            size_t count = times.size();
+            if (count == 0) {
+                return;
+            }
+
+            size_t index = 0;
+            while (index * arity + 1 < count) {
+                size_t min_child = minChild(index * arity + 1, count);
+                times[index] = times[min_child];
+                values[index] = values[min_child];
+                index = min_child;
+            }
+            siftUp(index, last_time, last_value);
+        }
+
+        /// @brief remove entries whose deadline <= now, calling on_expired(value) in deadline order.
+        /// O(k log n) for few expired entries, switches to compactExpired() (O(n)) when many expire together
+        template<class F>
+        void pop_expired(clock::nanoseconds now, F&& on_expired) {
+            size_t pop_budget = std::max<size_t>(64, times.size() / 32);
+            while (!times.empty() && times.front() <= now) {
+                if (pop_budget-- == 0) {
+                    compactExpired(now, on_expired);
+                    return;
+                }
+                on_expired(values.front());
+                pop();
+            }
+        }
+
+        /// @brief remove entries whose value matches the predicate (e.g. of reclaimed task queues) in O(n)
+        /// @return number of removed entries
+        template<class P>
+        size_t remove_if(P&& predicate) {
+            size_t count = times.size();
+            size_t kept = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (!predicate(values[i])) {
+                    times[kept] = times[i];
+                    values[kept] = values[i];
+                    kept++;
+                }
+            }
+            times.resize(kept);
+            values.resize(kept);
+            rebuild();
+            return count - kept;
+        }
+
+        void clear() {
+            times.clear();
+            values.clear();
+        }
+
+        size_t capacityBytes() const {
+            return times.capacity() * sizeof(clock::nanoseconds) + values.capacity() * sizeof(T)
+                + expired.capacity() * sizeof(std::pair<clock::nanoseconds, T>);
+        }
+    };
+
+    /// @brief multi-producer single-consumer queue (Vyukov's intrusive list).
+    /// push() can be called from any thread: it allocates one node with new (the global allocator may lock),
+    /// then links it with one atomic exchange. consume() must be called by one thread only.
+    /// the consumer checks emptiness with one atomic load (no mutex)
+    template<class T>
+    class mpsc_queue
+    {
+    private:
+        struct node
+        {
+            std::atomic<node*> next { nullptr };
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+            T& value() {
+                return *reinterpret_cast<T*>(&storage);
+            }
+        };
+
+        /// last pushed node (producers)
+        std::atomic<node*> head;
+        /// consumed node, whose next is the oldest one (consumer). its value is already moved out
+        node* tail;
+
+    public:
+        mpsc_queue() {
+            tail = new node();
+            head.store(tail, std::memory_order_relaxed);
+        }
+
+        ~mpsc_queue() {
+            consume([](T&&) {});
+            delete tail;
+        }
+
+        mpsc_queue(const mpsc_queue&) = delete;
+        mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+        void push(T&& value) {
+            node* n = new node();
+            new (&n->storage) T(std::move(value));
+            node* prev = head.exchange(n, std::memory_order_acq_rel);
+            prev->next.store(n, std::memory_order_release);
+        }
+
+        bool empty() const {
+            return tail->next.load(std::memory_order_acquire) == nullptr;
+        }
+
+        /// @brief call f(T&&) for each pushed value in push order
+        /// (a value whose push is still in progress is left for the next call)
+        template<class F>
+        size_t consume(F&& f) {
+            size_t count = 0;
+            while (node* next = tail->next.load(std::memory_order_acquire)) {
+                T value = std::move(next->value());
+                next->value().~T();
+                delete tail;
+                tail = next;
+                f(std::move(value));
+                count++;
+            }
+            return count;
+        }
+    };
+
+    /// index + generation, which detects that the slot was reused
+    struct slot_key
+    {
+        static constexpr uint32_t invalid_index = std::numeric_limits<uint32_t>::max();
+
+        uint32_t index = invalid_index;
+        uint32_t generation = 0;
+
+        bool operator==(const slot_key& other) const {
+            return this->index == other.index && this->generation == other.generation;
+        }
+        bool operator!=(const slot_key& other) const {
+            return !(*this == other);
+        }
+    };
+
+    /// @brief generational slot map. elements never move (stored in fixed size chunks),
+    /// removed slots are reused, and alive elements are also listed densely for iteration.
+    template<class T, size_t ChunkSize = 256>
+    class slot_map
+    {
+    private:
+        struct slot
+        {
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+            uint32_t generation = 0;
+            uint32_t dense_index = slot_key::invalid_index;
+
+            T& value() {
+                return *reinterpret_cast<T*>(&storage);
+            }
+            bool alive() const {
+                return dense_index != slot_key::invalid_index;
+            }
+        };
+
+        std::vector<std::unique_ptr<slot[]>> chunks;
+        std::vector<uint32_t> free_indices;
+        std::vector<uint32_t> dense;
+        uint32_t slot_count = 0;
+
+        slot& at(uint32_t index) const {
+            return chunks[index / ChunkSize][index % ChunkSize];
+        }
+
+    public:
+        slot_map() = default;
+        slot_map(const slot_map&) = delete;
+        slot_map& operator=(const slot_map&) = delete;
+
+        ~slot_map() {
+            clear();
+        }
+
+        /// key of the slot which will be used by next emplace()
+        slot_key next_key() const {
+            if (!free_indices.empty()) {
+                uint32_t index = free_indices.back();
+                return { index, at(index).generation };
+            }
+            return { slot_count, 0 };
+        }
+
+        template<class... Args>
+        slot_key emplace(Args&&... args) {
+            slot_key key = next_key();
+            if (free_indices.empty()) {
+                if (slot_count % ChunkSize == 0) {
+                    chunks.emplace_back(new slot[ChunkSize]);
+                }
+                slot_count++;
+            }else{
+                free_indices.pop_back();
+            }
+
+            slot& s = at(key.index);
+            new (&s.storage) T(std::forward<Args>(args)...);
+            s.dense_index = static_cast<uint32_t>(dense.size());
+            dense.push_back(key.index);
+            return key;
+        }
+
+        /// O(1) removal. the key (and the other keys for this slot) become expired
+        void erase(slot_key key) {
+            if (!contains(key)) {
+                return;
+            }
+            slot& s = at(key.index);
+            s.value().~T();
+            s.generation++;
+
+            // swap and pop dense list
+            uint32_t moved = dense.back();
+            dense[s.dense_index] = moved;
+            at(moved).dense_index = s.dense_index;
+            dense.pop_back();
+
+            s.dense_index = slot_key::invalid_index;
+            free_indices.push_back(key.index);
+        }
+
+        bool contains(slot_key key) const {
+            if (key.index >= slot_count) {
+                return false;
+            }
+            const slot& s = at(key.index);
+            return s.alive() && s.generation == key.generation;
+        }
+
+        /// returns nullptr if expired
+        T* get(slot_key key) {
+            if (!contains(key)) {
+                return nullptr;
+            }
+            return &at(key.index).value();
+        }
+
+        const T* get(slot_key key) const {
+            if (!contains(key)) {
+                return nullptr;
+            }
+            return &at(key.index).value();
+        }
+
+        size_t size() const {
+            return dense.size();
+        }
+
+        bool empty() const {
+            return dense.empty();
+        }
+
+        /// number of allocated slots (alive + reusable)
+        size_t capacity() const {
+            return chunks.size() * ChunkSize;
+        }
+
+        void clear() {
+            for (uint32_t index : dense) {
+                slot& s = at(index);
+                s.value().~T();
+                s.generation++;
+                s.dense_index = slot_key::invalid_index;
+                free_indices.push_back(index);
+            }
+            dense.clear();
+        }
+
+        /// iterate alive elements (dense)
+        template<class F>
+        void for_each(F&& f) {
+            for (uint32_t index : dense) {
+                f(at(index).value());
+            }
+        }
+    };
+
+} // namespace container
+
+namespace symbol {
+
+    class SymbolTable;
+
+    /// @brief interned name (compact integer id). the string is only materialized by str()
+    class Symbol {
+    private:
+        uint32_t _id;
+
+    public:
+        /// ids with this bit are anonymous (unique, no string until str() is called)
+        static constexpr uint32_t anonymous_bit = 0x80000000u;
+
+        explicit Symbol(uint32_t id = 0) : _id(id) {}
+
+        uint32_t id() const {
+            return this->_id;
+        }
+
+        bool isAnonymous() const {
+            return (this->_id & anonymous_bit) != 0;
+        }
+
+        inline std::string str() const;
+
+        bool operator==(const Symbol& other) const {
+            return this->_id == other._id;
+        }
+        bool operator!=(const Symbol& other) const {
+            return this->_id != other._id;
+        }
+    };
+
+    /// @brief name <-> Symbol table. interning locks (names are interned on setup or when building task queues),
+    /// creating anonymous symbols doesn't.
+    class SymbolTable {
+    private:
+        std::unordered_map<std::string, uint32_t> ids;
+        std::deque<std::string> names;
+        std::atomic<uint32_t> anonymous_counter { 0 };
+        mutable std::mutex mutex;
+
+        static SymbolTable shared_symbol_table;
+
+    public:
+        /// empty name is Symbol() (id 0)
+        SymbolTable() {
+            intern("");
+        }
+
+        static SymbolTable& shared() {
+            return shared_symbol_table;
+        }
+
+        Symbol intern(const std::string& name) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = ids.find(name);
+            if (it != ids.end()) {
+                return Symbol(it->second);
+            }
+            uint32_t id = static_cast<uint32_t>(names.size());
+            names.push_back(name);
+            ids.emplace(name, id);
+            return Symbol(id);
+        }
+
+        /// unique symbol without name (named "task_queue_<number>" when needed)
+        Symbol anonymous() {
+            uint32_t number = anonymous_counter.fetch_add(1, std::memory_order_relaxed);
+            return Symbol(Symbol::anonymous_bit | (number & ~Symbol::anonymous_bit));
+        }
+
+        /// (names of anonymous symbols are built on each call, not kept: queues may be spawned without limit)
+        std::string name(Symbol symbol) const {
+            if (symbol.isAnonymous()) {
+                return "task_queue_" + std::to_string(symbol.id() & ~Symbol::anonymous_bit);
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            return names[symbol.id()];
+        }
+
+        size_t size() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return names.size();
+        }
+    };
+
+    inline std::string Symbol::str() const {
+        return SymbolTable::shared().name(*this);
+    }
+
+    inline Symbol intern(const std::string& name) {
+        return SymbolTable::shared().intern(name);
+    }
+
+} // namespace symbol
+
+namespace sync {
+
+    /// barrier of a sync group. released (generation is incremented) when all members arrived
+    struct Barrier {
+        size_t member_count = 0;
+        size_t arrived_count = 0;
+        std::atomic<uint64_t> generation { 0 };
+        /// latest arrival time in current generation, and that of the last release
+        /// (drift-free waits continue from release time, same for all members)
+        clock::nanoseconds latest_arrival_time = std::numeric_limits<clock::nanoseconds>::min();
+        std::atomic<clock::nanoseconds> release_time { 0 };
+    };
+
+    /// @brief barriers of sync groups used by ofxTaskRunner (see ofxTaskRunner::setSyncGroups()).
+    /// a group is looked up by name only once per task queue (join()), waits use the integer index after that
+    class SyncBackend {
+    public:
+        virtual ~SyncBackend() = default;
+
+        virtual void registerTaskId(int task_id) = 0;
+
+        /// @brief join the group as a member (only registered task ids join)
+        /// @return group index, or -1 if not a member
+        virtual int join(int task_id, symbol::Symbol name) = 0;
+
+        /// @brief leave the group (members which finished don't block others)
+        /// @param arrived_generation return value of arrive() if the member leaves without waiting for the release (cancelled)
+        virtual void leave(int group, uint64_t arrived_generation = 0) = 0;
+
+        /// @brief arrive at the barrier
+        /// @param arrival_time time when the wait of this member was done
+        /// @return generation which releases this arrival
+        virtual uint64_t arrive(int group, clock::nanoseconds arrival_time) = 0;
+
+        virtual bool isReleased(int group, uint64_t target_generation) const = 0;
+
+        /// time of the last release (latest arrival time among members)
+        virtual clock::nanoseconds getReleaseTime(int group) const = 0;
+
+        virtual size_t getGroupCount() const = 0;
+    };
+
+    /// @brief sync groups in this process (task queues with the same name and registered task ids which have a sync wait).
+    /// shared among runners by default (see shared()), locking is needed only when runners are on other threads.
+    class SyncGroups : public SyncBackend {
+    private:
+        std::deque<Barrier> barriers;
+        /// group index for each name (symbol id)
+        std::unordered_map<uint32_t, int> group_indices;
+        std::vector<int> registered_task_ids;
+        bool thread_safe = false;
+        mutable std::mutex mutex;
+
+        static SyncGroups shared_sync_groups;
+
+        std::unique_lock<std::mutex> lock() const {
+            if (thread_safe) {
+                return std::unique_lock<std::mutex>(mutex);
+            }
+            return std::unique_lock<std::mutex>();
+        }
+
+        bool tryRelease(Barrier& barrier) {
+            if (barrier.arrived_count > 0 && barrier.arrived_count >= barrier.member_count) {
+                barrier.arrived_count = 0;
+                barrier.release_time.store(barrier.latest_arrival_time, std::memory_order_relaxed);
+                barrier.latest_arrival_time = std::numeric_limits<clock::nanoseconds>::min();
+                barrier.generation.fetch_add(1, std::memory_order_release);
+                return true;
+            }
+            return false;
+        }
+
+    public:
+        /// sync groups used by all runners in this process
+        static SyncGroups& shared() {
+            return shared_sync_groups;
+        }
+
+        /// lock on join, arrival and release check (needed when runners using same groups are updated on different threads)
+        void setThreadSafe(bool thread_safe) {
+            this->thread_safe = thread_safe;
+        }
+
+        void registerTaskId(int task_id) override {
+            auto l = lock();
+            if (std::find(registered_task_ids.begin(), registered_task_ids.end(), task_id) == registered_task_ids.end()) {
+                registered_task_ids.push_back(task_id);
+            }
+        }
+
+        int join(int task_id, symbol::Symbol name) override {
+            auto l = lock();
+            if (std::find(registered_task_ids.begin(), registered_task_ids.end(), task_id) == registered_task_ids.end()) {
+                return -1;
+            }
+
+            auto it = group_indices.find(name.id());
+            int group = 0;
+            if (it == group_indices.end()) {
+                group = static_cast<int>(barriers.size());
+                barriers.emplace_back();
+                group_indices.emplace(name.id(), group);
+            }else{
+                group = it->second;
+            }
+            barriers[group].member_count++;
+            return group;
+        }
+
+        void leave(int group, uint64_t arrived_generation = 0) override {
+            auto l = lock();
+            Barrier& barrier = barriers[group];
+            barrier.member_count--;
+            if (arrived_generation > barrier.generation.load(std::memory_order_relaxed) && barrier.arrived_count > 0) {
+                barrier.arrived_count--;
+            }
+            tryRelease(barrier);
+        }
+
+        uint64_t arrive(int group, clock::nanoseconds arrival_time) override {
+            auto l = lock();
+            Barrier& barrier = barriers[group];
+            uint64_t target = barrier.generation.load(std::memory_order_relaxed) + 1;
+            barrier.latest_arrival_time = std::max(barrier.latest_arrival_time, arrival_time);
+            barrier.arrived_count++;
+            tryRelease(barrier);
+            return target;
+        }
+
+        /// (locks too: join() of a new group may reallocate the index of barriers meanwhile)
+        bool isReleased(int group, uint64_t target_generation) const override {
+            auto l = lock();
+            return barriers[group].generation.load(std::memory_order_acquire) >= target_generation;
+        }
+
+        clock::nanoseconds getReleaseTime(int group) const override {
+            auto l = lock();
+            return barriers[group].release_time.load(std::memory_order_relaxed);
+        }
+
+        size_t getGroupCount() const override {
+            auto l = lock();
+            return barriers.size();
+        }
+    };
+
+#ifdef OFX_TASKRUNNER_SHARED_MEMORY_SYNC
+    /// @brief sync groups shared by processes on one machine (e.g. one openFrameworks process per display),
+    /// kept in a POSIX shared memory segment and updated with lock-free atomics only (no locks, no sockets).
+    /// use getClock() as the clock of the runners, so arrival / release times are comparable among processes.
+    /// members of a crashed process are not removed: remove() the segment before restarting all processes.
+    /// a group has at most max_members members (in all processes)
+    class SharedMemorySyncGroups : public SyncBackend {
+    public:
+        static constexpr size_t max_groups = 256;
+        static constexpr size_t max_name_length = 63;
+        /// (member and arrived counts are 16 bits of the barrier word)
+        static constexpr uint32_t max_members = 0xffff;
+
+        /// @brief steady clock counted from the epoch stored in the segment (same time in all processes)
+        class SharedEpochClock : public clock::Clock {
+        private:
+            const std::atomic<clock::nanoseconds>* epoch = nullptr;
+
+        public:
+            void setEpoch(const std::atomic<clock::nanoseconds>* epoch) {
+                this->epoch = epoch;
+            }
+
+            clock::nanoseconds now() override {
+                clock::nanoseconds time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+                return epoch != nullptr ? time - epoch->load(std::memory_order_relaxed) : time;
+            }
+        };
+
+    private:
+        static constexpr uint32_t segment_magic = 0x6f665452;
+        static constexpr uint32_t segment_version = 2;
+
+        /// @brief barrier in shared memory. generation (32 bits), member count and arrived count (16 bits each)
+        /// are packed into one word, so join / arrival / leave / release is a single compare-and-swap
+        struct SharedBarrier {
+            /// 0: free, 1: being named, 2: named
+            std::atomic<uint32_t> state;
+            char name[max_name_length + 1];
+            std::atomic<uint64_t> word;
+            /// @brief latest arrival time of a generation (indexed by generation parity), tagged with the generation
+            /// (see packArrival()). a slot is taken over by the first arrival of a newer generation, so it never has to be
+            /// reset on release, and the release time is read from the slot of the released generation
+            std::atomic<uint64_t> latest_arrival[2];
+        };
+
+        struct Segment {
+            std::atomic<uint32_t> magic;
+            uint32_t version;
+            std::atomic<clock::nanoseconds> epoch;
+            SharedBarrier barriers[max_groups];
+        };
+
+        std::string segment_name;
+        /// permissions of a created segment
+        mode_t mode;
+        Segment* segment = nullptr;
+        SharedEpochClock shared_clock;
+
+        /// group index for each name (symbol id), and registered task ids of this process
+        std::unordered_map<uint32_t, int> group_indices;
+        std::vector<int> registered_task_ids;
+        mutable std::mutex mutex;
+
+        static uint32_t generationOf(uint64_t word) {
+            return static_cast<uint32_t>(word >> 32);
+        }
+
+        static uint64_t pack(uint32_t generation, uint32_t member_count, uint32_t arrived_count) {
+            return (static_cast<uint64_t>(generation) << 32) | (static_cast<uint64_t>(member_count & 0xffff) << 16) | (arrived_count & 0xffff);
+        }
+
+        /// generations wrap around (compared by difference)
+        static bool isReached(uint32_t generation, uint64_t target_generation) {
+            return static_cast<int32_t>(generation - static_cast<uint32_t>(target_generation)) >= 0;
+        }
+
+        /// low 16 bits of the generation, and the time in microseconds (48 bits, signed)
+        static uint64_t packArrival(uint32_t generation, clock::nanoseconds time) {
+            return (static_cast<uint64_t>(generation & 0xffff) << 48) | (static_cast<uint64_t>(time / 1000) & 0xffffffffffffull);
+        }
+
+        static uint16_t tagOf(uint64_t arrival) {
+            return static_cast<uint16_t>(arrival >> 48);
+        }
+
+        static clock::nanoseconds timeOf(uint64_t arrival) {
+            // (sign-extend 48 bits)
+            return (static_cast<int64_t>(arrival << 16) >> 16) * 1000;
+        }
+
+        /// store the arrival time if it is later than that of the generation, or the slot has an older generation
+        static void storeArrival(SharedBarrier& barrier, uint32_t generation, clock::nanoseconds time) {
+            std::atomic<uint64_t>& slot = barrier.latest_arrival[generation & 1];
+            uint64_t next = packArrival(generation, time);
+            uint64_t current = slot.load(std::memory_order_relaxed);
+            while (true) {
+                int16_t age = static_cast<int16_t>(static_cast<uint16_t>(generation) - tagOf(current));
+                if (age < 0 || (age == 0 && timeOf(current) >= timeOf(next))) {
+                    return;
+                }
+                if (slot.compare_exchange_weak(current, next, std::memory_order_relaxed)) {
+                    return;
+                }
+            }
+        }
+
+        /// @brief change member / arrived count by one compare-and-swap, and release the barrier when all members arrived
+        /// @return generation before the change
+        template <class F>
+        static uint32_t update(SharedBarrier& barrier, F&& change) {
+            uint64_t word = barrier.word.load(std::memory_order_acquire);
+            while (true) {
+                uint32_t generation = generationOf(word);
+                uint32_t member_count = (word >> 16) & 0xffff;
+                uint32_t arrived_count = word & 0xffff;
+                change(generation, member_count, arrived_count);
+
+                // (nothing else is written on release: arrival times are tagged with their generation)
+                bool release = arrived_count > 0 && arrived_count >= member_count;
+                if (release) {
+                    arrived_count = 0;
+                }
+                uint64_t next = pack(release ? generation + 1 : generation, member_count, arrived_count);
+                if (barrier.word.compare_exchange_weak(word, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                    return generation;
+                }
+            }
+        }
+
+        /// FNV-1a (same in all processes, unlike std::hash)
+        static uint32_t hashName(const std::string& name) {
+            uint32_t hash = 2166136261u;
+            for (char c : name) {
+                hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+            }
+            return hash;
+        }
+
+        /// @brief find or name the barrier of the group. probing starts from the hash of the name,
+        /// so all processes find the same barrier for the same name
+        int findGroup(const std::string& name) {
+            if (name.size() > max_name_length) {
+                adapter::LogError("ofxTaskRunner") << "sync group name is too long for shared memory: " << name;
+                return -1;
+            }
+            uint32_t hash = hashName(name);
+            for (size_t i = 0; i < max_groups; i++) {
+                int group = static_cast<int>((hash + i) % max_groups);
+                SharedBarrier& barrier = segment->barriers[group];
+                uint32_t state = barrier.state.load(std::memory_order_acquire);
+                if (state == 0) {
+                    if (barrier.state.compare_exchange_strong(state, 1, std::memory_order_acq_rel)) {
+                        std::memcpy(barrier.name, name.c_str(), name.size() + 1);
+                        barrier.state.store(2, std::memory_order_release);
+                        return group;
+                    }
+                }
+                while (state == 1) {
+                    std::this_thread::yield();
+                    state = barrier.state.load(std::memory_order_acquire);
+                }
+                if (std::strncmp(barrier.name, name.c_str(), sizeof(barrier.name)) == 0) {
+                    return group;
+                }
+            }
+            adapter::LogError("ofxTaskRunner") << "too many sync groups in shared memory (max " << max_groups << ")";
+            return -1;
+        }
+
+        bool open() {
+            if (!isSupported()) {
+                adapter::LogError("ofxTaskRunner") << "shared memory sync needs lock-free 32 / 64-bit atomics: " << segment_name;
+                return false;
+            }
+            int fd = shm_open(segment_name.c_str(), O_RDWR | O_CREAT | O_EXCL, mode);
+            bool created = fd >= 0;
+            if (!created && errno == EEXIST) {
+                fd = shm_open(segment_name.c_str(), O_RDWR, mode);
+            }
+            if (fd < 0) {
+                adapter::LogError("ofxTaskRunner") << "shm_open failed: " << segment_name << " (" << std::strerror(errno) << ")";
+                return false;
+            }
+
+            if (created) {
+                if (ftruncate(fd, sizeof(Segment)) != 0) {
+                    adapter::LogError("ofxTaskRunner") << "ftruncate failed: " << segment_name;
+                    ::close(fd);
+                    return false;
+                }
+            } else {
+                // wait for the creator to size it
+                struct stat st;
+                for (int retry = 0; fstat(fd, &st) == 0 && st.st_size < static_cast<off_t>(sizeof(Segment)); retry++) {
+                    if (retry >= 1000) {
+                        adapter::LogError("ofxTaskRunner") << "shared memory is not initialized: " << segment_name;
+                        ::close(fd);
+                        return false;
+                    }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+
+            void* address = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (address == MAP_FAILED) {
+                adapter::LogError("ofxTaskRunner") << "mmap failed: " << segment_name;
+                return false;
+            }
+            segment = static_cast<Segment*>(address);
+
+            if (created) {
+                new (segment) Segment();
+                for (SharedBarrier& barrier : segment->barriers) {
+                    // (generation -1 and -2: older than the first ones)
+                    barrier.latest_arrival[0].store(packArrival(static_cast<uint32_t>(-2), 0), std::memory_order_relaxed);
+                    barrier.latest_arrival[1].store(packArrival(static_cast<uint32_t>(-1), 0), std::memory_order_relaxed);
+                }
+                segment->version = segment_version;
+                segment->epoch.store(SharedEpochClock().now(), std::memory_order_relaxed);
+                segment->magic.store(segment_magic, std::memory_order_release);
+            } else {
+                for (int retry = 0; segment->magic.load(std::memory_order_acquire) != segment_magic; retry++) {
+                    if (retry >= 1000) {
+                        adapter::LogError("ofxTaskRunner") << "shared memory is not initialized: " << segment_name;
+                        close();
+                        return false;
+                    }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                if (segment->version != segment_version) {
+                    adapter::LogError("ofxTaskRunner") << "shared memory has other version: " << segment_name;
+                    close();
+                    return false;
+                }
+            }
+            shared_clock.setEpoch(&segment->epoch);
+            return true;
+        }
+
+        void close() {
+            if (segment != nullptr) {
+                munmap(segment, sizeof(Segment));
+                segment = nullptr;
+            }
+            shared_clock.setEpoch(nullptr);
+        }
+
+    public:
+        /// @brief open (or create) the segment. task queues don't sync if it failed (see isOpen() and isSupported())
+        /// @param segment_name POSIX shared memory name (starts with '/')
+        /// @param mode permissions of the segment if it is created (owner only by default; e.g. 0660 to share it with
+        /// processes of other users in the same group)
+        explicit SharedMemorySyncGroups(const std::string& segment_name = "/ofxTaskRunner", mode_t mode = 0600) : segment_name(segment_name), mode(mode) {
+            open();
+        }
+
+        /// (the segment itself stays until remove())
+        ~SharedMemorySyncGroups() override {
+            close();
+        }
+
+        SharedMemorySyncGroups(const SharedMemorySyncGroups&) = delete;
+        SharedMemorySyncGroups& operator=(const SharedMemorySyncGroups&) = delete;
+
+        /// @brief true if the atomics in the segment are lock-free, so they work across processes
+        /// (checked at runtime: e.g. armv6 has no 64-bit lock-free atomics, and the rest of the addon still builds there)
+        static bool isSupported() {
+            std::atomic<uint32_t> state(0);
+            std::atomic<uint64_t> word(0);
+            std::atomic<clock::nanoseconds> time(0);
+            return state.is_lock_free() && word.is_lock_free() && time.is_lock_free();
+        }
+
+        /// remove the segment (processes which opened it keep using it)
+        static bool remove(const std::string& segment_name = "/ofxTaskRunner") {
+            return shm_unlink(segment_name.c_str()) == 0;
+        }
+
+        bool isOpen() const {
+            return segment != nullptr;
+        }
+
+        /// clock whose time is the same in all processes using the segment (set it to runners by setClock())
+        clock::Clock& getClock() {
+            return shared_clock;
+        }
+
+        void registerTaskId(int task_id) override {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (std::find(registered_task_ids.begin(), registered_task_ids.end(), task_id) == registered_task_ids.end()) {
+                registered_task_ids.push_back(task_id);
+            }
+        }
+
+        int join(int task_id, symbol::Symbol name) override {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (segment == nullptr || std::find(registered_task_ids.begin(), registered_task_ids.end(), task_id) == registered_task_ids.end()) {
+                return -1;
+            }
+
+            auto it = group_indices.find(name.id());
+            int group = 0;
+            if (it == group_indices.end()) {
+                group = findGroup(name.str());
+                if (group < 0) {
+                    return -1;
+                }
+                group_indices.emplace(name.id(), group);
+            }else{
+                group = it->second;
+            }
+            // (a full group is not joined: the count would wrap around, and release the barrier early)
+            SharedBarrier& barrier = segment->barriers[group];
+            uint64_t word = barrier.word.load(std::memory_order_acquire);
+            do {
+                if (((word >> 16) & 0xffff) >= max_members) {
+                    adapter::LogError("ofxTaskRunner") << "sync group " << name.str() << " has " << max_members << " members already (not joined)";
+                    return -1;
+                }
+            } while (!barrier.word.compare_exchange_weak(word, word + (1ull << 16), std::memory_order_acq_rel, std::memory_order_acquire));
+            return group;
+        }
+
+        void leave(int group, uint64_t arrived_generation = 0) override {
+            update(segment->barriers[group], [arrived_generation](uint32_t generation, uint32_t& member_count, uint32_t& arrived_count) {
+                member_count--;
+                if (arrived_generation != 0 && !isReached(generation, arrived_generation) && arrived_count > 0) {
+                    arrived_count--;
+                }
+            });
+        }
+
+        uint64_t arrive(int group, clock::nanoseconds arrival_time) override {
+            SharedBarrier& barrier = segment->barriers[group];
+            uint32_t generation = generationOf(barrier.word.load(std::memory_order_acquire));
+            storeArrival(barrier, generation, arrival_time);
+            uint32_t arrived_generation = update(barrier, [](uint32_t, uint32_t&, uint32_t& arrived_count) {
+                arrived_count++;
+            });
+            if (arrived_generation != generation) {
+                // (released by others leaving meanwhile)
+                storeArrival(barrier, arrived_generation, arrival_time);
+            }
+            return static_cast<uint64_t>(arrived_generation) + 1;
+        }
+
+        bool isReleased(int group, uint64_t target_generation) const override {
+            return isReached(generationOf(segment->barriers[group].word.load(std::memory_order_acquire)), target_generation);
+        }
+
+        /// (microsecond resolution)
+        clock::nanoseconds getReleaseTime(int group) const override {
+            const SharedBarrier& barrier = segment->barriers[group];
+            uint32_t released_generation = generationOf(barrier.word.load(std::memory_order_acquire)) - 1;
+            uint64_t arrival = barrier.latest_arrival[released_generation & 1].load(std::memory_order_relaxed);
+            if (tagOf(arrival) != static_cast<uint16_t>(released_generation)) {
+                // (already taken over by the next generation: members continue from their own deadline)
+                return std::numeric_limits<clock::nanoseconds>::min();
+            }
+            return timeOf(arrival);
+        }
+
+        size_t getGroupCount() const override {
+            size_t count = 0;
+            for (size_t i = 0; segment != nullptr && i < max_groups; i++) {
+                count += segment->barriers[i].state.load(std::memory_order_acquire) == 2 ? 1 : 0;
+            }
+            return count;
+        }
+    };
+#endif
+
+} // namespace sync
+
+namespace async {
+
+    /// @brief fixed size worker threads for TaskQueue::then_async()
+    class ThreadPool {
+    private:
+        std::vector<std::thread> threads;
+        std::deque<functional::unique_function<void()>> jobs;
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool stopping = false;
+
+        void run() {
+            while (true) {
+                functional::unique_function<void()> job;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    condition.wait(lock, [this] { return stopping || !jobs.empty(); });
+                    if (stopping) {
+                        return;
+                    }
+                    job = std::move(jobs.front());
+                    jobs.pop_front();
+                }
+                job();
+            }
+        }
+
+    public:
+        explicit ThreadPool(size_t thread_count) {
+            for (size_t i = 0; i < std::max<size_t>(thread_count, 1); i++) {
+                threads.emplace_back([this] { run(); });
+            }
+        }
+
+        /// waits for running jobs (jobs not started yet are dropped)
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            condition.notify_all();
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        void submit(functional::unique_function<void()> job) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                jobs.push_back(std::move(job));
+            }
+            condition.notify_one();
+        }
+
+        size_t getThreadCount() const {
+            return threads.size();
+        }
+
+        static size_t getDefaultThreadCount() {
+            size_t hardware_threads = std::thread::hardware_concurrency();
+            return hardware_threads > 1 ? hardware_threads - 1 : 1;
+        }
+    };
+
+    /// @brief persistent worker threads running an index range together with the caller.
+    /// idle threads take the next index from a shared counter (self-scheduling: fast threads take more indices)
+    class ParallelFor {
+    private:
+        std::vector<std::thread> threads;
+        std::mutex mutex;
+        std::condition_variable start_condition;
+        std::condition_variable done_condition;
+        uint64_t generation = 0;
+        size_t running_count = 0;
+        bool stopping = false;
+
+        // current job (set before generation is bumped)
+        void* context = nullptr;
+        void (*invoke)(void*, size_t) = nullptr;
+        size_t count = 0;
+        std::atomic<size_t> next_index { 0 };
+
+        void work() {
+            for (size_t i = next_index.fetch_add(1, std::memory_order_relaxed); i < count; i = next_index.fetch_add(1, std::memory_order_relaxed)) {
+                invoke(context, i);
+            }
+        }
+
+        void workerLoop() {
+            uint64_t seen_generation = 0;
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    start_condition.wait(lock, [&] { return stopping || generation != seen_generation; });
+                    if (stopping) {
+                        return;
+                    }
+                    seen_generation = generation;
+                }
+                work();
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    running_count--;
+                }
+                done_condition.notify_one();
+            }
+        }
+
+    public:
+        explicit ParallelFor(size_t thread_count) {
+            for (size_t i = 0; i < thread_count; i++) {
+                threads.emplace_back([this] { workerLoop(); });
+            }
+        }
+
+        ~ParallelFor() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            start_condition.notify_all();
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+
+        ParallelFor(const ParallelFor&) = delete;
+        ParallelFor& operator=(const ParallelFor&) = delete;
+
+        /// @brief call f(i) for i in [0, count) on the workers and the calling thread, returns when all finished
+        template <class F>
+        void run(size_t index_count, F& f) {
+            if (threads.empty() || index_count <= 1) {
+                for (size_t i = 0; i < index_count; i++) {
+                    f(i);
+                }
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                context = &f;
+                invoke = [](void* ctx, size_t i) { (*static_cast<F*>(ctx))(i); };
+                count = index_count;
+                next_index.store(0, std::memory_order_relaxed);
+                running_count = threads.size();
+                generation++;
+            }
+            start_condition.notify_all();
+            work();
+            std::unique_lock<std::mutex> lock(mutex);
+            done_condition.wait(lock, [this] { return running_count == 0; });
+        }
+
+        size_t getThreadCount() const {
+            return threads.size();
+        }
+    };
+
+} // namespace async
+
+namespace trace {
+
+    enum class EventType : uint8_t {
+        UPDATE,
+        DRAW,
+        ASYNC,
+        CREATE_TASK_QUEUE,
+        PROCESS_TASK_QUEUES,
+    };
+
+    inline const char* toString(EventType type) {
+        switch (type) {
+            case EventType::UPDATE: return "update";
+            case EventType::DRAW: return "draw";
+            case EventType::ASYNC: return "async";
+            case EventType::CREATE_TASK_QUEUE: return "create_task_queue";
+            case EventType::PROCESS_TASK_QUEUES: return "process_task_queues";
+        }
+        return "";
+    }
+
+    /// which step is executed (label is set by TaskQueue::label())
+    struct TraceTag {
+        symbol::Symbol task_queue_name;
+        int task_id = 0;
+        symbol::Symbol label;
+    };
+
+    /// executed step (or scheduler phase)
+    struct Event {
+        clock::nanoseconds begin = 0;
+        clock::nanoseconds end = 0;
+        TraceTag tag;
+        EventType type = EventType::UPDATE;
+        uint32_t thread = 0;
+    };
+
+    /// monotonic time shared among runners (std::chrono::steady_clock)
+    inline clock::nanoseconds now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /// small id of current thread, in order of first event
+    inline uint32_t threadIndex() {
+        static std::atomic<uint32_t> thread_counter { 0 };
+        thread_local uint32_t thread_index = thread_counter.fetch_add(1, std::memory_order_relaxed);
+        return thread_index;
+    }
+
+    inline void writeJsonString(std::ostream& out, const std::string& str) {
+        out << '"';
+        for (char c : str) {
+            switch (c) {
+                case '"': out << "\\\""; break;
+                case '\\': out << "\\\\"; break;
+                case '\n': out << "\\n"; break;
+                case '\t': out << "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        char buffer[8];
+                        std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                        out << buffer;
+                    } else {
+                        out << c;
+                    }
+            }
+        }
+        out << '"';
+    }
+
+    /// @brief fixed size ring buffer of events (oldest events are overwritten when full).
+    /// record() is lock-free, and can be called from worker threads
+    class TraceBuffer {
+    private:
+        /// sequence is odd while the event is written (readers skip it)
+        struct Slot {
+            std::atomic<uint64_t> sequence { 0 };
+            Event event;
+        };
+
+        std::unique_ptr<Slot[]> slots;
+        size_t capacity;
+        std::atomic<uint64_t> write_index { 0 };
+
+    public:
+        /// @param capacity number of events (rounded up to power of two)
+        explicit TraceBuffer(size_t capacity) {
+            this->capacity = 1;
+            while (this->capacity < capacity) {
+                this->capacity <<= 1;
+            }
+            slots.reset(new Slot[this->capacity]);
+        }
+
+        void record(const Event& event) {
+            uint64_t index = write_index.fetch_add(1, std::memory_order_relaxed);
+            Slot& slot = slots[index & (capacity - 1)];
+            slot.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            slot.event = event;
+            slot.sequence.store(index * 2 + 2, std::memory_order_release);
+        }
+
+        size_t getCapacity() const {
+            return capacity;
+        }
+
+        /// number of events recorded (including overwritten ones)
+        uint64_t getRecordedCount() const {
+            return write_index.load(std::memory_order_relaxed);
+        }
+
+        /// iterate kept events (from oldest). events being written are skipped
+        template<class F>
+        void for_each(F&& f) const {
+            uint64_t end = write_index.load(std::memory_order_acquire);
+            uint64_t begin = end > capacity ? end - capacity : 0;
+            for (uint64_t index = begin; index < end; index++) {
+                const Slot& slot = slots[index & (capacity - 1)];
+                uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+                if (sequence != index * 2 + 2) {
+                    continue;
+                }
+                Event event = slot.event;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+                    continue;
+                }
+                f(event);
+            }
+        }
+
+        /// write as Chrome trace JSON (chrome://tracing, https://ui.perfetto.dev)
+        void writeChromeJson(std::ostream& out) const {
+            clock::nanoseconds origin = std::numeric_limits<clock::nanoseconds>::max();
+            for_each([&origin](const Event& event) {
+                origin = std::min(origin, event.begin);
+            });
+
+            out << "{\"traceEvents\":[";
+            bool first = true;
+            char buffer[64];
+            for_each([&](const Event& event) {
+                out << (first ? "\n" : ",\n");
+                first = false;
+
+                out << "{\"name\":";
+                writeJsonString(out, event.tag.label != symbol::Symbol() ? event.tag.label.str() : toString(event.type));
+                out << ",\"cat\":\"" << toString(event.type) << "\",\"ph\":\"X\"";
+                std::snprintf(buffer, sizeof(buffer), ",\"ts\":%.3f,\"dur\":%.3f",
+                    (event.begin - origin) / 1000.0, (event.end - event.begin) / 1000.0);
+                out << buffer << ",\"pid\":0,\"tid\":" << event.thread;
+                if (event.type != EventType::PROCESS_TASK_QUEUES) {
+                    out << ",\"args\":{\"task_queue\":";
+                    writeJsonString(out, event.tag.task_queue_name.str());
+                    out << ",\"task_id\":" << event.tag.task_id << "}";
+                }
+                out << "}";
+            });
+            out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+        }
+    };
+
+    /// records an event from construction to destruction (nothing if buffer is null)
+    class TraceScope {
+    private:
+        TraceBuffer* buffer;
+        Event event;
+
+    public:
+        TraceScope(TraceBuffer* buffer, EventType type, const TraceTag& tag = TraceTag()) : buffer(buffer) {
+            if (buffer != nullptr) {
+                event.type = type;
+                event.tag = tag;
+                event.begin = now();
+            }
+        }
+
+        ~TraceScope() {
+            if (buffer != nullptr) {
+                event.end = now();
+                event.thread = threadIndex();
+                buffer->record(event);
+            }
+        }
+
+        TraceScope(const TraceScope&) = delete;
+        TraceScope& operator=(const TraceScope&) = delete;
+    };
+
+} // namespace trace
+
+namespace stats {
+
+    /// @brief histogram of durations with power of two buckets
+    /// (bucket 0: 0ns, bucket i: [2^(i-1), 2^i) ns)
+    class Histogram {
+    public:
+        static constexpr size_t bucket_count = 64;
+
+    private:
+        std::array<uint64_t, bucket_count> buckets {};
+        uint64_t count = 0;
+        clock::nanoseconds sum = 0;
+        clock::nanoseconds min_value = 0;
+        clock::nanoseconds max_value = 0;
+
+        static size_t bucketOf(clock::nanoseconds value) {
+            size_t bucket = 0;
+            for (uint64_t v = static_cast<uint64_t>(value); v != 0; v >>= 1) {
+                bucket++;
+            }
+            return std::min(bucket, bucket_count - 1);
+        }
+
+    public:
+        /// negative values are counted as 0
+        void add(clock::nanoseconds value) {
+            value = std::max<clock::nanoseconds>(value, 0);
+            buckets[bucketOf(value)]++;
+            min_value = count == 0 ? value : std::min(min_value, value);
+            max_value = std::max(max_value, value);
+            sum += value;
+            count++;
+        }
+
+        /// add the values counted by other
+        void merge(const Histogram& other) {
+            if (other.count == 0) {
+                return;
+            }
+            for (size_t i = 0; i < bucket_count; i++) {
+                buckets[i] += other.buckets[i];
+            }
+            min_value = count == 0 ? other.min_value : std::min(min_value, other.min_value);
+            max_value = std::max(max_value, other.max_value);
+            sum += other.sum;
+            count += other.count;
+        }
+
+        void reset() {
+            *this = Histogram();
+        }
+
+        uint64_t getCount() const {
+            return count;
+        }
+
+        clock::nanoseconds getMin() const {
+            return min_value;
+        }
+
+        clock::nanoseconds getMax() const {
+            return max_value;
+        }
+
+        clock::nanoseconds getMean() const {
+            return count > 0 ? sum / static_cast<clock::nanoseconds>(count) : 0;
+        }
+
+        uint64_t getBucket(size_t bucket) const {
+            return buckets[bucket];
+        }
+
+        /// upper bound of values in the bucket (exclusive)
+        static clock::nanoseconds getBucketUpperBound(size_t bucket) {
+            return bucket == 0 ? 1 : (bucket >= bucket_count - 1 ? std::numeric_limits<clock::nanoseconds>::max() : clock::nanoseconds(1) << bucket);
+        }
+
+        /// @brief approximate percentile (upper bound of the bucket, at most getMax())
+        /// @param percentile 0.0 - 100.0
+        clock::nanoseconds getPercentile(double percentile) const {
+            if (count == 0) {
+                return 0;
+            }
+            uint64_t target = static_cast<uint64_t>(std::ceil(count * std::min(std::max(percentile, 0.0), 100.0) / 100.0));
+            uint64_t accumulated = 0;
+            for (size_t bucket = 0; bucket < bucket_count; bucket++) {
+                accumulated += buckets[bucket];
+                if (accumulated >= std::max<uint64_t>(target, 1)) {
+                    return std::min(getBucketUpperBound(bucket), max_value);
+                }
+            }
+            return max_value;
+        }
+    };
+
+    /// @brief snapshot of ofxTaskRunner state (see ofxTaskRunner::getStats())
+    struct Stats {
+        size_t task_queue_count = 0;
+        size_t ready_task_queue_count = 0;
+        size_t waiting_task_queue_count = 0;
+        /// steps not executed yet (in all task queues)
+        size_t pending_task_count = 0;
+        /// update / draw callbacks and task queue creations collected but not run yet (e.g. deferred by budget)
+        size_t pending_callback_count = 0;
+        /// memory held by steps of task queues
+        size_t task_storage_bytes = 0;
+        /// memory held by task queue slots and scheduler lists
+        size_t scheduler_bytes = 0;
+        size_t sync_group_count = 0;
+        /// running tween steps
+        size_t tween_count = 0;
+        /// task queues parked on wait_for_event() (including cancelled ones until they are pruned)
+        size_t event_waiter_count = 0;
+        /// entries of the name and task_id indexes of cancelByName() / cancelByTaskId() (names / task ids of alive queues)
+        size_t index_entry_count = 0;
+
+        /// high-water marks (since construction or resetStats())
+        size_t max_task_queue_count = 0;
+        size_t max_pending_task_count = 0;
+        size_t max_task_storage_bytes = 0;
+
+        /// time of processTaskQueues() per update()
+        Histogram process_time;
+        /// how late waits finished after their deadline (including frame granularity)
+        Histogram wait_lateness;
+    };
+
+} // namespace stats
+
+namespace tween {
+
+    /// easing curve of TaskQueue::tween()
+    enum class Easing {
+        LINEAR,
+        QUAD_IN,
+        QUAD_OUT,
+        QUAD_IN_OUT,
+        CUBIC_IN,
+        CUBIC_OUT,
+        CUBIC_IN_OUT,
+    };
+
+    constexpr size_t easing_count = 7;
+
+    /// @brief eased progress (t: 0.0 - 1.0). branch free, so a loop with constant easing is vectorized
+    inline float ease(Easing easing, float t) {
+        float u = 1.0f - t;
+        switch (easing) {
+            case Easing::LINEAR: return t;
+            case Easing::QUAD_IN: return t * t;
+            case Easing::QUAD_OUT: return 1.0f - u * u;
+            case Easing::QUAD_IN_OUT: return t < 0.5f ? 2.0f * t * t : 1.0f - 2.0f * u * u;
+            case Easing::CUBIC_IN: return t * t * t;
+            case Easing::CUBIC_OUT: return 1.0f - u * u * u;
+            case Easing::CUBIC_IN_OUT: return t < 0.5f ? 4.0f * t * t * t : 1.0f - 4.0f * u * u * u;
+        }
+        return t;
+    }
+
+    /// @brief running tweens in structure-of-arrays, one lane per easing.
+    /// evaluate() computes all values of a lane in one tight loop (no callback per tween), then writes them to targets
+    class TweenTable {
+    public:
+        /// row id: index in lane * easing_count + lane
+        static constexpr uint32_t invalid_row = std::numeric_limits<uint32_t>::max();
+
+    private:
+        struct Lane {
+            std::vector<float*> targets;
+            std::vector<float> from;
+            std::vector<float> delta;
+            std::vector<float> inv_duration;
+            std::vector<clock::nanoseconds> start;
+            std::vector<clock::nanoseconds> end;
+            std::vector<container::slot_key> owners;
+            /// values computed on evaluate() (before written to targets)
+            std::vector<float> values;
+
+            size_t size() const {
+                return targets.size();
+            }
+
+            size_t capacityBytes() const {
+                return targets.capacity() * sizeof(float*)
+                    + (from.capacity() + delta.capacity() + inv_duration.capacity() + values.capacity()) * sizeof(float)
+                    + (start.capacity() + end.capacity()) * sizeof(clock::nanoseconds)
+                    + owners.capacity() * sizeof(container::slot_key);
+            }
+        };
+
+        std::array<Lane, easing_count> lanes;
+
+        static uint32_t rowOf(size_t lane, size_t index) {
+            return static_cast<uint32_t>(index * easing_count + lane);
+        }
+
+        /// move the last row of the lane to index (on_moved(owner, row) is called for the moved one)
+        template <typename OnMoved>
+        void removeAt(size_t lane_index, size_t index, OnMoved&& on_moved) {
+            Lane& lane = lanes[lane_index];
+            size_t last = lane.size() - 1;
+            if (index != last) {
+                lane.targets[index] = lane.targets[last];
+                lane.from[index] = lane.from[last];
+                lane.delta[index] = lane.delta[last];
+                lane.inv_duration[index] = lane.inv_duration[last];
+                lane.start[index] = lane.start[last];
+                lane.end[index] = lane.end[last];
+                lane.owners[index] = lane.owners[last];
+                on_moved(lane.owners[index], rowOf(lane_index, index));
+            }
+            lane.targets.pop_back();
+            lane.from.pop_back();
+            lane.delta.pop_back();
+            lane.inv_duration.pop_back();
+            lane.start.pop_back();
+            lane.end.pop_back();
+            lane.owners.pop_back();
+        }
+
+        template <Easing E>
+        static void computeValues(Lane& lane, clock::nanoseconds now) {
+            size_t n = lane.size();
+            lane.values.resize(n);
+            const clock::nanoseconds* start = lane.start.data();
+            const float* inv_duration = lane.inv_duration.data();
+            const float* from = lane.from.data();
+            const float* delta = lane.delta.data();
+            float* values = lane.values.data();
+            for (size_t i = 0; i < n; i++) {
+                float t = static_cast<float>(now - start[i]) * inv_duration[i];
+                t = std::min(std::max(t, 0.0f), 1.0f);
+                values[i] = from[i] + delta[i] * ease(E, t);
+            }
+        }
+
+        static void computeValues(size_t lane_index, Lane& lane, clock::nanoseconds now) {
+            switch (static_cast<Easing>(lane_index)) {
+                case Easing::LINEAR: computeValues<Easing::LINEAR>(lane, now); break;
+                case Easing::QUAD_IN: computeValues<Easing::QUAD_IN>(lane, now); break;
+                case Easing::QUAD_OUT: computeValues<Easing::QUAD_OUT>(lane, now); break;
+                case Easing::QUAD_IN_OUT: computeValues<Easing::QUAD_IN_OUT>(lane, now); break;
+                case Easing::CUBIC_IN: computeValues<Easing::CUBIC_IN>(lane, now); break;
+                case Easing::CUBIC_OUT: computeValues<Easing::CUBIC_OUT>(lane, now); break;
+                case Easing::CUBIC_IN_OUT: computeValues<Easing::CUBIC_IN_OUT>(lane, now); break;
+            }
+        }
+
+    public:
+        /// @brief add tween running from start to end, and write its value at now
+        /// @return row id (changes when other rows are removed, see on_moved of remove() / evaluate())
+        uint32_t add(container::slot_key owner, float* target, float from, float to, Easing easing, clock::nanoseconds start, clock::nanoseconds end, clock::nanoseconds now) {
+            size_t lane_index = static_cast<size_t>(easing);
+            Lane& lane = lanes[lane_index];
+            float inv_duration = end > start ? 1.0f / static_cast<float>(end - start) : 0.0f;
+            lane.targets.push_back(target);
+            lane.from.push_back(from);
+            lane.delta.push_back(to - from);
+            lane.inv_duration.push_back(inv_duration);
+            lane.start.push_back(start);
+            lane.end.push_back(end);
+            lane.owners.push_back(owner);
+
+            float t = std::min(std::max(static_cast<float>(now - start) * inv_duration, 0.0f), 1.0f);
+            *target = from + (to - from) * ease(easing, t);
+            return rowOf(lane_index, lane.size() - 1);
+        }
+
+        /// remove tween before it finished (e.g. cancelled)
+        template <typename OnMoved>
+        void remove(uint32_t row, OnMoved&& on_moved) {
+            removeAt(row % easing_count, row / easing_count, on_moved);
+        }
+
+        /// @brief write values of all tweens at now, and remove finished ones (on_finished(owner) is called)
+        template <typename OnFinished, typename OnMoved>
+        void evaluate(clock::nanoseconds now, OnFinished&& on_finished, OnMoved&& on_moved) {
+            for (size_t lane_index = 0; lane_index < easing_count; lane_index++) {
+                Lane& lane = lanes[lane_index];
+                if (lane.size() == 0) {
+                    continue;
+                }
+
+                computeValues(lane_index, lane, now);
+                for (size_t i = 0; i < lane.size(); i++) {
+                    *lane.targets[i] = lane.values[i];
+                }
+
+                for (size_t i = 0; i < lane.size(); ) {
+                    if (lane.end[i] <= now) {
+                        on_finished(lane.owners[i]);
+                        removeAt(lane_index, i, on_moved);
+                    } else {
+                        i++;
+                    }
+                }
+            }
+        }
+
+        size_t size() const {
+            size_t count = 0;
+            for (const Lane& lane : lanes) {
+                count += lane.size();
+            }
+            return count;
+        }
+
+        size_t capacityBytes() const {
+            size_t bytes = 0;
+            for (const Lane& lane : lanes) {
+                bytes += lane.capacityBytes();
+            }
+            return bytes;
+        }
+
+        void clear() {
+            for (Lane& lane : lanes) {
+                lane = Lane();
+            }
+        }
+    };
+
+} // namespace tween
+
+} // namespace taskrunner
+
+// compiled out unless OFX_TASKRUNNER_TRACE is defined (see ofxTaskRunner::startTrace())
+#ifdef OFX_TASKRUNNER_TRACE
+    #define OFX_TASKRUNNER_TRACE_SCOPE(buffer, type, tag) taskrunner::trace::TraceScope _trace_scope(buffer, type, tag)
+#else
+    #define OFX_TASKRUNNER_TRACE_SCOPE(buffer, type, tag)
+#endif
+
+// ===============================================
+
+enum class TaskType {
+    WAIT,
+    DRAW,
+    UPDATE,
+    CREATE_TASK_QUEUE,
+    ASYNC,
+    PROGRAM,
+    TWEEN,
+    WAIT_EVENT,
+    WAIT_UNTIL,
+    JOIN,
+};
+
+/// priority of update tasks (see ofxTaskRunner::setUpdateBudget())
+enum class TaskPriority {
+    NORMAL,
+    /// never deferred by the update budget
+    CRITICAL,
+};
+
+class WaitTask {
+public:
+    taskrunner::clock::nanoseconds wait_time;
+    /// wait until all members of the sync group finished this wait (see taskrunner::sync::SyncGroups)
+    bool need_sync;
+
+    WaitTask(taskrunner::clock::nanoseconds wait_time, bool need_sync) {
+        this->wait_time = wait_time;
+        this->need_sync = need_sync;
+    }
+};
+
+template <typename App>
+using TaskFunction = taskrunner::functional::unique_function<void(App&)>;
+
+template <typename App>
+class DrawTask {
+public:
+    TaskFunction<App> draw_task;
+
+    DrawTask(TaskFunction<App>&& draw_task) {
+        this->draw_task = std::move(draw_task);
+    }
+};
+
+template <typename App>
+class UpdateTask {
+public:
+    TaskFunction<App> update_task;
+    TaskPriority priority;
+
+    UpdateTask(TaskFunction<App>&& update_task, TaskPriority priority = TaskPriority::NORMAL) {
+        this->update_task = std::move(update_task);
+        this->priority = priority;
+    }
+};
+
+/// work which runs on a worker thread (see TaskQueue::then_async())
+class AsyncTask {
+public:
+    taskrunner::functional::unique_function<void()> async_task;
+
+    AsyncTask(taskrunner::functional::unique_function<void()>&& async_task) {
+        this->async_task = std::move(async_task);
+    }
+};
+
+/// @brief animate float value (evaluated by ofxTaskRunner in a batch, see taskrunner::tween::TweenTable)
+class TweenTask {
+public:
+    taskrunner::clock::nanoseconds duration;
+    float* target;
+    float from;
+    float to;
+    taskrunner::tween::Easing easing;
+
+    TweenTask(taskrunner::clock::nanoseconds duration, float* target, float from, float to, taskrunner::tween::Easing easing) {
+        this->duration = duration;
+        this->target = target;
+        this->from = from;
+        this->to = to;
+        this->easing = easing;
+    }
+};
+
+/// wait until ofxTaskRunner::notify() of the channel (see TaskQueue::wait_for_event())
+class EventWaitTask {
+public:
+    taskrunner::symbol::Symbol channel;
+
+    EventWaitTask(taskrunner::symbol::Symbol channel) {
+        this->channel = channel;
+    }
+};
+
+template <typename App>
+using PredicateFunction = taskrunner::functional::unique_function<bool(App&)>;
+
+/// wait until the predicate returns true, checked once per interval (see TaskQueue::wait_until())
+template <typename App>
+class WaitUntilTask {
+public:
+    PredicateFunction<App> predicate;
+    taskrunner::clock::nanoseconds interval;
+
+    WaitUntilTask(PredicateFunction<App>&& predicate, taskrunner::clock::nanoseconds interval) {
+        this->predicate = std::move(predicate);
+        this->interval = interval;
+    }
+};
+
+/// kind of TaskProgram step
+enum class ProgramStepType {
+    WAIT,
+    UPDATE,
+    DRAW,
+    /// jump back to the first step of the block (see TaskProgram::repeat())
+    REPEAT,
+    /// wait for ofxTaskRunner::notify() of Step::channel
+    WAIT_EVENT,
+};
+
+/// step function of TaskProgram (param is given per instance, e.g. index of fixture)
+template <typename App>
+using ProgramFunction = taskrunner::functional::unique_function<void(App&, int)>;
+
+template <typename App>
+class TaskQueue;
+
+/// @brief sequence which is built once, and instantiated by many task queues (see TaskQueue::then_program()).
+/// instances share the steps (built program is immutable), and only keep a cursor and param
+template <typename App>
+class TaskProgram {
+public:
+    struct Step {
+        ProgramStepType type = ProgramStepType::WAIT;
+        taskrunner::clock::nanoseconds wait_time = 0;
+        bool need_sync = false;
+        /// deadline is computed from the previous deadline, even if the queue is not drift-free (see every_ms())
+        bool drift_free = false;
+        TaskPriority priority = TaskPriority::NORMAL;
+        ProgramFunction<App> func;
+        /// UPDATE / DRAW: callback without param, used instead of func (steps moved from a TaskQueue by repeat() / loop())
+        TaskFunction<App> task;
+        /// REPEAT: number of runs of the block (0: forever), its first step,
+        /// and whether it has a wait to sleep on (if not, next run is on next update)
+        uint32_t repeat_count = 0;
+        size_t jump_to = 0;
+        bool has_wait = false;
+        /// WAIT_EVENT: channel to wait for
+        taskrunner::symbol::Symbol channel;
+        /// name in trace
+        taskrunner::symbol::Symbol label;
+    };
+
+private:
+    friend class TaskQueue<App>;
+
+    std::vector<Step> steps;
+    /// first step of the block which is repeated by next repeat() / loop()
+    size_t block_start = 0;
+
+    TaskProgram<App>& push(Step&& step) {
+        steps.push_back(std::move(step));
+        return *this;
+    }
+
+    TaskProgram<App>& pushWait(taskrunner::clock::nanoseconds wait_time, bool need_sync, bool drift_free) {
+        Step step;
+        step.type = ProgramStepType::WAIT;
+        step.wait_time = wait_time;
+        step.need_sync = need_sync;
+        step.drift_free = drift_free;
+        return push(std::move(step));
+    }
+
+public:
+    /// add wait step (in nanoseconds)
+    TaskProgram<App>& wait_ns(taskrunner::clock::nanoseconds wait_time, bool need_sync = false) {
+        return pushWait(wait_time, need_sync, false);
+    }
+
+    /// add wait step (in seconds)
+    TaskProgram<App>& wait_sec(double wait_time_sec, bool need_sync = false) {
+        return wait_ns(taskrunner::clock::fromSec(wait_time_sec), need_sync);
+    }
+
+    /// add wait step (in milliseconds)
+    TaskProgram<App>& wait_ms(double wait_time_millis, bool need_sync = false) {
+        return wait_ns(taskrunner::clock::fromMillis(wait_time_millis), need_sync);
+    }
+
+    /// add sync wait step (in seconds)
+    TaskProgram<App>& wait_sync_sec(double wait_time_sec) {
+        return wait_sec(wait_time_sec, true);
+    }
+
+    /// add sync wait step (in milliseconds)
+    TaskProgram<App>& wait_sync_ms(double wait_time_millis) {
+        return wait_ms(wait_time_millis, true);
+    }
+
+    /// add step which waits for ofxTaskRunner::notify() of the channel
+    TaskProgram<App>& wait_for_event(taskrunner::symbol::Symbol channel) {
+        Step step;
+        step.type = ProgramStepType::WAIT_EVENT;
+        step.channel = channel;
+        return push(std::move(step));
+    }
+
+    TaskProgram<App>& wait_for_event(const std::string& channel) {
+        return wait_for_event(taskrunner::symbol::intern(channel));
+    }
+
+    /// add draw step
+    TaskProgram<App>& then_on_draw(ProgramFunction<App> draw_task) {
+        Step step;
+        step.type = ProgramStepType::DRAW;
+        step.func = std::move(draw_task);
+        return push(std::move(step));
+    }
+
+    /// add update step
+    TaskProgram<App>& then_on_update(ProgramFunction<App> update_task, TaskPriority priority = TaskPriority::NORMAL) {
+        return pushUpdate(std::move(update_task), priority);
+    }
+
+    /// add update step (alias)
+    TaskProgram<App>& then(ProgramFunction<App> update_task, TaskPriority priority = TaskPriority::NORMAL) {
+        return then_on_update(std::move(update_task), priority);
+    }
+
+    /// @brief run the steps since previous repeat() / loop() (or the first step) count times in total
+    /// (0 is an error: the steps run once, use loop() to run them forever)
+    TaskProgram<App>& repeat(uint32_t count) {
+        if (count <= 1) {
+            if (count == 0) {
+                taskrunner::adapter::LogError("ofxTaskRunner") << "repeat(0) is not supported (the steps run once, use loop() to run them forever)";
+            }
+            block_start = steps.size();
+            return *this;
+        }
+        return pushRepeat(count);
+    }
+
+    /// run the steps since previous repeat() / loop() (or the first step) forever
+    TaskProgram<App>& loop() {
+        return pushRepeat(0);
+    }
+
+    /// @brief call func every period (drift-free: deadlines are computed from the previous deadline, so it doesn't drift on frame drops)
+    /// @param count number of calls (0: forever)
+    TaskProgram<App>& every_ms(double period_millis, ProgramFunction<App> func, uint32_t count = 0) {
+        return pushEvery(period_millis, std::move(func), count);
+    }
+
+    /// name the last added step in trace
+    TaskProgram<App>& label(const std::string& label) {
+        return this->label(taskrunner::symbol::intern(label));
+    }
+
+    TaskProgram<App>& label(taskrunner::symbol::Symbol label) {
+        if (!steps.empty()) {
+            steps.back().label = label;
+        }
+        return *this;
+    }
+
+    /// @brief freeze steps into a shared immutable program (this builder becomes empty)
+    std::shared_ptr<const TaskProgram<App>> build() {
+        auto program = std::make_shared<const TaskProgram<App>>(std::move(*this));
+        steps.clear();
+        block_start = 0;
+        return program;
+    }
+
+    size_t size() const {
+        return steps.size();
+    }
+
+    const Step& at(size_t index) const {
+        return steps[index];
+    }
+
+    /// @brief true if any wait step needs sync (the task queue joins its sync group)
+    bool hasSyncWait() const {
+        for (const Step& step : steps) {
+            if (step.type == ProgramStepType::WAIT && step.need_sync) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// @brief total wait time of a run including repeats (event waits count as 0,
+    /// loop() is infinite: std::numeric_limits<taskrunner::clock::nanoseconds>::max())
+    taskrunner::clock::nanoseconds getDuration() const {
+        taskrunner::clock::nanoseconds duration = 0;
+        for (size_t i = 0; i < steps.size(); i++) {
+            const Step& step = steps[i];
+            if (step.type == ProgramStepType::WAIT) {
+                duration += step.wait_time;
+            } else if (step.type == ProgramStepType::REPEAT) {
+                if (step.repeat_count == 0) {
+                    return std::numeric_limits<taskrunner::clock::nanoseconds>::max();
+                }
+                taskrunner::clock::nanoseconds block = 0;
+                for (size_t j = step.jump_to; j < i; j++) {
+                    block += steps[j].type == ProgramStepType::WAIT ? steps[j].wait_time : 0;
+                }
+                duration += block * (step.repeat_count - 1);
+            }
+        }
+        return duration;
+    }
+
+private:
+    TaskProgram<App>& pushUpdate(ProgramFunction<App>&& update_task, TaskPriority priority) {
+        Step step;
+        step.type = ProgramStepType::UPDATE;
+        step.priority = priority;
+        step.func = std::move(update_task);
+        return push(std::move(step));
+    }
+
+    /// (steps of TaskQueue: the callback is kept as is, instead of wrapping it into a ProgramFunction)
+    TaskProgram<App>& pushUpdate(TaskFunction<App>&& update_task, TaskPriority priority) {
+        Step step;
+        step.type = ProgramStepType::UPDATE;
+        step.priority = priority;
+        step.task = std::move(update_task);
+        return push(std::move(step));
+    }
+
+    TaskProgram<App>& pushDraw(TaskFunction<App>&& draw_task) {
+        Step step;
+        step.type = ProgramStepType::DRAW;
+        step.task = std::move(draw_task);
+        return push(std::move(step));
+    }
+
+    template <class Function>
+    TaskProgram<App>& pushEvery(double period_millis, Function&& func, uint32_t count) {
+        block_start = steps.size();
+        pushWait(taskrunner::clock::fromMillis(period_millis), false, true);
+        pushUpdate(std::move(func), TaskPriority::NORMAL);
+        return count == 0 ? loop() : repeat(count);
+    }
+
+    TaskProgram<App>& pushRepeat(uint32_t count) {
+        if (block_start == steps.size()) {
+            return *this;
+        }
+        Step step;
+        step.type = ProgramStepType::REPEAT;
+        step.repeat_count = count;
+        step.jump_to = block_start;
+        for (size_t i = block_start; i < steps.size(); i++) {
+            if ((steps[i].type == ProgramStepType::WAIT && steps[i].wait_time > 0) || steps[i].type == ProgramStepType::WAIT_EVENT) {
+                step.has_wait = true;
+            }
+        }
+        push(std::move(step));
+        block_start = steps.size();
+        return *this;
+    }
+};
+
+template <typename App>
+using TaskProgramRef = std::shared_ptr<const TaskProgram<App>>;
+
+/// @brief dependency graph of sequences (e.g. cues: "start C when A and B finished"). a node runs its program
+/// when all of its dependencies finished. built once (validated, sorted topologically and analyzed for the
+/// critical path), and run by ofxTaskRunner::runGraph() any number of times
+template <typename App>
+class TaskGraph {
+public:
+    using NodeId = uint32_t;
+
+    struct Node {
+        /// name of the task queue of this node (sync groups, cancelByName())
+        taskrunner::symbol::Symbol name;
+        TaskProgramRef<App> program;
+        int task_id = 0;
+        int param = 0;
+        /// see TaskProgram::getDuration()
+        taskrunner::clock::nanoseconds duration = 0;
+        /// filled by build(): earliest start, and latest start which doesn't delay the graph (from the start of a run)
+        taskrunner::clock::nanoseconds earliest_start = 0;
+        taskrunner::clock::nanoseconds latest_start = 0;
+    };
+
+private:
+    std::vector<Node> nodes;
+    /// (dependency, dependent) pairs until build()
+    std::vector<std::pair<NodeId, NodeId>> edges;
+    /// successors of node i are successors[successor_offsets[i] .. successor_offsets[i + 1]] (filled by build())
+    std::vector<uint32_t> successor_offsets;
+    std::vector<NodeId> successors;
+    std::vector<uint32_t> in_degrees;
+    std::vector<NodeId> topological_order;
+    std::vector<NodeId> critical_path;
+    taskrunner::clock::nanoseconds critical_path_duration = 0;
+
+    /// (saturates at infinite duration of loop())
+    static taskrunner::clock::nanoseconds addDuration(taskrunner::clock::nanoseconds a, taskrunner::clock::nanoseconds b) {
+        taskrunner::clock::nanoseconds infinite = std::numeric_limits<taskrunner::clock::nanoseconds>::max();
+        return a >= infinite - b ? infinite : a + b;
+    }
+
+    /// @brief fill CSR successors and in-degrees, and sort topologically (Kahn's algorithm)
+    /// @return false if there is a cycle
+    bool sort() {
+        size_t node_count = nodes.size();
+        in_degrees.assign(node_count, 0);
+        successor_offsets.assign(node_count + 1, 0);
+        for (const auto& edge : edges) {
+            successor_offsets[edge.first + 1]++;
+            in_degrees[edge.second]++;
+        }
+        for (size_t i = 0; i < node_count; i++) {
+            successor_offsets[i + 1] += successor_offsets[i];
+        }
+        successors.resize(edges.size());
+        std::vector<uint32_t> cursors(successor_offsets.begin(), successor_offsets.end() - 1);
+        for (const auto& edge : edges) {
+            successors[cursors[edge.first]++] = edge.second;
+        }
+
+        std::vector<uint32_t> remaining = in_degrees;
+        topological_order.clear();
+        topological_order.reserve(node_count);
+        for (NodeId i = 0; i < node_count; i++) {
+            if (remaining[i] == 0) {
+                topological_order.push_back(i);
+            }
+        }
+        for (size_t i = 0; i < topological_order.size(); i++) {
+            NodeId node = topological_order[i];
+            for (uint32_t j = successor_offsets[node]; j < successor_offsets[node + 1]; j++) {
+                if (--remaining[successors[j]] == 0) {
+                    topological_order.push_back(successors[j]);
+                }
+            }
+        }
+        if (topological_order.size() == node_count) {
+            return true;
+        }
+        for (NodeId i = 0; i < node_count; i++) {
+            if (remaining[i] > 0) {
+                taskrunner::adapter::LogError("ofxTaskRunner") << "task graph has a cycle through node " << nodes[i].name.str();
+                break;
+            }
+        }
+        return false;
+    }
+
+    /// earliest / latest start of each node (by durations of the programs), and the longest path
+    void analyzeCriticalPath() {
+        std::vector<NodeId> critical_predecessor(nodes.size(), static_cast<NodeId>(nodes.size()));
+        critical_path_duration = 0;
+        NodeId last = 0;
+        for (NodeId node : topological_order) {
+            taskrunner::clock::nanoseconds finish = addDuration(nodes[node].earliest_start, nodes[node].duration);
+            if (finish >= critical_path_duration) {
+                critical_path_duration = finish;
+                last = node;
+            }
+            for (uint32_t j = successor_offsets[node]; j < successor_offsets[node + 1]; j++) {
+                Node& successor = nodes[successors[j]];
+                if (critical_predecessor[successors[j]] == nodes.size() || finish > successor.earliest_start) {
+                    successor.earliest_start = finish;
+                    critical_predecessor[successors[j]] = node;
+                }
+            }
+        }
+
+        critical_path.clear();
+        for (NodeId node = last; !nodes.empty() && node < nodes.size(); node = critical_predecessor[node]) {
+            critical_path.push_back(node);
+        }
+        std::reverse(critical_path.begin(), critical_path.end());
+
+        for (auto it = topological_order.rbegin(); it != topological_order.rend(); ++it) {
+            Node& node = nodes[*it];
+            taskrunner::clock::nanoseconds latest_finish = critical_path_duration;
+            for (uint32_t j = successor_offsets[*it]; j < successor_offsets[*it + 1]; j++) {
+                latest_finish = std::min(latest_finish, nodes[successors[j]].latest_start);
+            }
+            node.latest_start = latest_finish - std::min(node.duration, latest_finish);
+        }
+    }
+
+public:
+    /// @brief add node which runs the program (see TaskQueue::then_program())
+    /// @param task_id task id of the task queue (e.g. registered for sync groups)
+    NodeId node(taskrunner::symbol::Symbol name, TaskProgramRef<App> program, int task_id = 0, int param = 0) {
+        if (!program) {
+            // (the node is kept, so edges to it are valid: it finishes as soon as it starts)
+            taskrunner::adapter::LogError("ofxTaskRunner") << "task graph node " << name.str() << " program is null (ignored)";
+        }
+        Node node;
+        node.name = name;
+        node.duration = program ? program->getDuration() : 0;
+        node.program = std::move(program);
+        node.task_id = task_id;
+        node.param = param;
+        nodes.push_back(std::move(node));
+        return static_cast<NodeId>(nodes.size() - 1);
+    }
+
+    NodeId node(const std::string& name, TaskProgramRef<App> program, int task_id = 0, int param = 0) {
+        return this->node(taskrunner::symbol::intern(name), std::move(program), task_id, param);
+    }
+
+    /// node starts after the dependency finished
+    TaskGraph<App>& after(NodeId node, NodeId dependency) {
+        edges.emplace_back(dependency, node);
+        return *this;
+    }
+
+    /// node starts after all of the dependencies finished
+    TaskGraph<App>& after(NodeId node, std::initializer_list<NodeId> dependencies) {
+        for (NodeId dependency : dependencies) {
+            after(node, dependency);
+        }
+        return *this;
+    }
+
+    /// @brief validate and freeze the graph (this builder becomes empty)
+    /// @return nullptr if an edge refers to an unknown node or there is a cycle (logged)
+    std::shared_ptr<const TaskGraph<App>> build() {
+        TaskGraph<App> graph = std::move(*this);
+        *this = TaskGraph<App>();
+
+        for (const auto& edge : graph.edges) {
+            if (edge.first >= graph.nodes.size() || edge.second >= graph.nodes.size()) {
+                taskrunner::adapter::LogError("ofxTaskRunner") << "task graph edge refers to unknown node";
+                return nullptr;
+            }
+        }
+        if (!graph.sort()) {
+            return nullptr;
+        }
+        graph.analyzeCriticalPath();
+        graph.edges.clear();
+        graph.edges.shrink_to_fit();
+        return std::make_shared<const TaskGraph<App>>(std::move(graph));
+    }
+
+    size_t size() const {
+        return nodes.size();
+    }
+
+    const Node& at(NodeId node) const {
+        return nodes[node];
+    }
+
+    /// number of dependencies of each node (built graph)
+    const std::vector<uint32_t>& getInDegrees() const {
+        return in_degrees;
+    }
+
+    /// dependents of the node (built graph)
+    const NodeId* successorsBegin(NodeId node) const {
+        return successors.data() + successor_offsets[node];
+    }
+
+    const NodeId* successorsEnd(NodeId node) const {
+        return successors.data() + successor_offsets[node + 1];
+    }
+
+    const std::vector<NodeId>& getTopologicalOrder() const {
+        return topological_order;
+    }
+
+    /// @brief longest chain of nodes by durations (what to shorten to end the graph earlier)
+    const std::vector<NodeId>& getCriticalPath() const {
+        return critical_path;
+    }
+
+    /// expected duration of a run (length of the critical path)
+    taskrunner::clock::nanoseconds getCriticalPathDuration() const {
+        return critical_path_duration;
+    }
+
+    /// how much the node can be late without delaying the graph (0 on the critical path)
+    taskrunner::clock::nanoseconds getSlack(NodeId node) const {
+        return nodes[node].latest_start - nodes[node].earliest_start;
+    }
+};
+
+template <typename App>
+using TaskGraphRef = std::shared_ptr<const TaskGraph<App>>;
+
+/// handle of a run of TaskGraph (see ofxTaskRunner::runGraph())
+using TaskGraphRunHandle = taskrunner::container::slot_key;
+
+/// running instance of TaskProgram
+template <typename App>
+class ProgramTask {
+public:
+    TaskProgramRef<App> program;
+    /// index of current step
+    size_t step = 0;
+    /// number of finished runs of current repeat() block
+    uint32_t iteration = 0;
+    bool started = false;
+    int param;
+
+    ProgramTask(TaskProgramRef<App> program, int param) {
+        this->program = std::move(program);
+        this->param = param;
+    }
+};
+
+template <typename App>
+class ofxTaskRunner;
+
+/// @brief lightweight reference to a TaskQueue, which stays valid when the queue storage grows,
+/// and safely reports expiry after the queue finished (see ofxTaskRunner::getTaskQueue())
+using TaskQueueHandle = taskrunner::container::slot_key;
+
+template <typename App>
+using CreateTaskQueueFunction = taskrunner::functional::unique_function<void(TaskQueue<App>&)>;
+
+template <typename App>
+class CreateTaskQueueTask {
+public:
+    CreateTaskQueueFunction<App> func_for_new_task_queue;
+    int task_id;
+    taskrunner::symbol::Symbol task_queue_name;
+    /// task queue which added this task (the new queue is cancelled with it)
+    TaskQueueHandle parent;
+    CreateTaskQueueTask(int task_id, taskrunner::symbol::Symbol task_queue_name, TaskQueueHandle parent, CreateTaskQueueFunction<App>&& func_for_new_task_queue) {
+        this->task_id = task_id;
+        this->task_queue_name = task_queue_name;
+        this->parent = parent;
+        this->func_for_new_task_queue = std::move(func_for_new_task_queue);
+    }
+};
+
+/// @brief start child task queues and wait until all (or any) of them finished (see TaskQueue::then_all())
+template <typename App>
+class JoinTask {
+public:
+    std::vector<CreateTaskQueueFunction<App>> children;
+    /// true: finish when the first child finished (the others are cancelled)
+    bool any;
+    /// children were started
+    bool started = false;
+
+    JoinTask(std::vector<CreateTaskQueueFunction<App>>&& children, bool any) {
+        this->children = std::move(children);
+        this->any = any;
+    }
+};
+
+/// callback collected for update() / draw() (with the step which added it on OFX_TASKRUNNER_TRACE)
+template <typename App>
+struct PendingTask {
+    TaskFunction<App> task;
+    /// task queue which is parked until this update callback ran (see ofxTaskRunner::setUpdateBudget())
+    TaskQueueHandle parked;
+#ifdef OFX_TASKRUNNER_TRACE
+    taskrunner::trace::TraceTag tag;
+#endif
+};
+
+/// @brief one step of TaskQueue. tagged union of the tasks above,
+/// stored inline (contiguously) in TaskQueue without per-task heap allocation
+template <typename App>
+class Task {
+private:
+    TaskType type;
+
+    void destroy() {
+        switch (this->type) {
+            case TaskType::WAIT: wait.~WaitTask(); break;
+            case TaskType::DRAW: draw.~DrawTask<App>(); break;
+            case TaskType::UPDATE: update.~UpdateTask<App>(); break;
+            case TaskType::CREATE_TASK_QUEUE: create_task_queue.~CreateTaskQueueTask<App>(); break;
+            case TaskType::ASYNC: async.~AsyncTask(); break;
+            case TaskType::PROGRAM: program.~ProgramTask<App>(); break;
+            case TaskType::TWEEN: tween.~TweenTask(); break;
+            case TaskType::WAIT_EVENT: wait_event.~EventWaitTask(); break;
+            case TaskType::WAIT_UNTIL: wait_until.~WaitUntilTask<App>(); break;
+            case TaskType::JOIN: join.~JoinTask<App>(); break;
+        }
+    }
+
+    void moveFrom(Task&& other) {
+        this->type = other.type;
+#ifdef OFX_TASKRUNNER_TRACE
+        this->label = other.label;
+#endif
+        switch (other.type) {
+            case TaskType::WAIT: new (&wait) WaitTask(std::move(other.wait)); break;
+            case TaskType::DRAW: new (&draw) DrawTask<App>(std::move(other.draw)); break;
+            case TaskType::UPDATE: new (&update) UpdateTask<App>(std::move(other.update)); break;
+            case TaskType::CREATE_TASK_QUEUE: new (&create_task_queue) CreateTaskQueueTask<App>(std::move(other.create_task_queue)); break;
+            case TaskType::ASYNC: new (&async) AsyncTask(std::move(other.async)); break;
+            case TaskType::PROGRAM: new (&program) ProgramTask<App>(std::move(other.program)); break;
+            case TaskType::TWEEN: new (&tween) TweenTask(std::move(other.tween)); break;
+            case TaskType::WAIT_EVENT: new (&wait_event) EventWaitTask(std::move(other.wait_event)); break;
+            case TaskType::WAIT_UNTIL: new (&wait_until) WaitUntilTask<App>(std::move(other.wait_until)); break;
+            case TaskType::JOIN: new (&join) JoinTask<App>(std::move(other.join)); break;
+        }
+    }
+
+public:
+    union {
+        WaitTask wait;
+        DrawTask<App> draw;
+        UpdateTask<App> update;
+        CreateTaskQueueTask<App> create_task_queue;
+        AsyncTask async;
+        ProgramTask<App> program;
+        TweenTask tween;
+        EventWaitTask wait_event;
+        WaitUntilTask<App> wait_until;
+        JoinTask<App> join;
+    };
+
+#ifdef OFX_TASKRUNNER_TRACE
+    /// name in trace (see TaskQueue::label())
+    taskrunner::symbol::Symbol label;
+#endif
+
+    Task(WaitTask&& task) : type(TaskType::WAIT), wait(std::move(task)) {}
+    Task(DrawTask<App>&& task) : type(TaskType::DRAW), draw(std::move(task)) {}
+    Task(UpdateTask<App>&& task) : type(TaskType::UPDATE), update(std::move(task)) {}
+    Task(CreateTaskQueueTask<App>&& task) : type(TaskType::CREATE_TASK_QUEUE), create_task_queue(std::move(task)) {}
+    Task(AsyncTask&& task) : type(TaskType::ASYNC), async(std::move(task)) {}
+    Task(ProgramTask<App>&& task) : type(TaskType::PROGRAM), program(std::move(task)) {}
+    Task(TweenTask&& task) : type(TaskType::TWEEN), tween(std::move(task)) {}
+    Task(EventWaitTask&& task) : type(TaskType::WAIT_EVENT), wait_event(std::move(task)) {}
+    Task(WaitUntilTask<App>&& task) : type(TaskType::WAIT_UNTIL), wait_until(std::move(task)) {}
+    Task(JoinTask<App>&& task) : type(TaskType::JOIN), join(std::move(task)) {}
+
+    Task(Task&& other) noexcept {
+        moveFrom(std::move(other));
+    }
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            moveFrom(std::move(other));
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        destroy();
+    }
+
+    TaskType getTaskType() const {
+        return this->type;
+    }
+
+    /// name in trace (always empty without OFX_TASKRUNNER_TRACE)
+    taskrunner::symbol::Symbol getLabel() const {
+#ifdef OFX_TASKRUNNER_TRACE
+        return this->label;
+#else
+        return taskrunner::symbol::Symbol();
+#endif
+    }
+};
+
+// ================================================
+
+/// @brief intrusive links of a task queue to others with the same name / task_id, and to its parent and
+/// children (task queues created by then_create_task_queue()). maintained by ofxTaskRunner, so cancel doesn't scan
+struct TaskQueueLinks {
+    struct Node {
+        TaskQueueHandle prev;
+        TaskQueueHandle next;
+    };
+
+    Node by_name;
+    Node by_task_id;
+    Node siblings;
+    TaskQueueHandle parent;
+    TaskQueueHandle first_child;
+};
+
+/// @brief cancels a task queue without keeping a reference to it (see TaskQueue::getCancelToken())
+template <typename App>
+class CancelToken {
+private:
+    ofxTaskRunner<App>* runner = nullptr;
+    TaskQueueHandle handle;
+
+public:
+    CancelToken() = default;
+    CancelToken(ofxTaskRunner<App>& runner, TaskQueueHandle handle) : runner(&runner), handle(handle) {}
+
+    /// @brief cancel the task queue and the task queues created by it (see ofxTaskRunner::cancel()).
+    /// after the task queue finished, this still cancels the queues created by it which are running
+    /// @return number of cancelled task queues
+    size_t cancel() const {
+        return runner != nullptr ? runner->cancel(handle) : 0;
+    }
+
+    /// true until the task queue finished or was cancelled
+    bool isActive() const {
+        return runner != nullptr && runner->isAlive(handle) && !runner->isCancelled(handle);
+    }
+
+    TaskQueueHandle getHandle() const {
+        return handle;
+    }
+};
+
+template <typename App>
+class TaskQueue {
+private:
+    /// tasks are stored contiguously, and consumed by moving cursor (not popped)
+    taskrunner::memory::vector<Task<App>> tasks;
+    size_t cursor = 0;
+    /// first task of the block which is repeated by next repeat() / loop()
+    size_t loop_start = 0;
+
+    /// deadline of the wait task at cursor (valid if wait_started)
+    taskrunner::clock::nanoseconds wait_deadline = 0;
+    bool wait_started = false;
+
+    /// drift-free mode: next wait starts from the end of the previous one (timeline), not from now
+    bool _drift_free = false;
+    taskrunner::clock::nanoseconds timeline = 0;
+    bool timeline_started = false;
+
+    /// owner runner and handle in its task_queues (used for scheduling)
+    ofxTaskRunner<App>* runner;
+    TaskQueueHandle _handle;
+
+    /// notify runner that this queue has something to do
+    void schedule() {
+        if (this->runner != nullptr) {
+            this->runner->scheduleTaskQueue(*this);
+        }
+    }
+
+    TaskQueue<App>& repeatSteps(uint32_t count) {
+        size_t begin = std::max(cursor, loop_start);
+        loop_start = tasks.size();
+        for (size_t i = begin; i < tasks.size(); i++) {
+            TaskType type = tasks[i].getTaskType();
+            if (type != TaskType::WAIT && type != TaskType::WAIT_EVENT && type != TaskType::UPDATE && type != TaskType::DRAW) {
+                taskrunner::adapter::LogError("ofxTaskRunner") << "repeat() / loop() supports only wait, wait_for_event and then steps (ignored)";
+                return *this;
+            }
+        }
+        if (begin == tasks.size()) {
+            return *this;
+        }
+
+        TaskProgram<App> program;
+        for (size_t i = begin; i < tasks.size(); i++) {
+            Task<App>& task = tasks[i];
+            switch (task.getTaskType()) {
+                case TaskType::WAIT:
+                    program.wait_ns(task.wait.wait_time, task.wait.need_sync);
+                    break;
+                case TaskType::WAIT_EVENT:
+                    program.wait_for_event(task.wait_event.channel);
+                    break;
+                case TaskType::UPDATE:
+                    program.pushUpdate(std::move(task.update.update_task), task.update.priority);
+                    break;
+                case TaskType::DRAW:
+                    program.pushDraw(std::move(task.draw.draw_task));
+                    break;
+                default:
+                    break;
+            }
+            program.label(task.getLabel());
+        }
+        if (count == 0) {
+            program.loop();
+        } else {
+            program.repeat(count);
+        }
+
+        size_t removed = tasks.size() - begin;
+        tasks.erase(tasks.begin() + begin, tasks.end());
+        runner->countTasks(-static_cast<int64_t>(removed), 0);
+        push(ProgramTask<App>(program.build(), 0));
+        loop_start = tasks.size();
+        return *this;
+    }
+
+    /// (unique_function is move-only, so children can't be listed by an initializer_list)
+    template <typename... F>
+    static std::vector<CreateTaskQueueFunction<App>> makeChildren(F... children) {
+        std::vector<CreateTaskQueueFunction<App>> functions;
+        functions.reserve(sizeof...(children));
+        int expand[] = { 0, (functions.emplace_back(std::move(children)), 0)... };
+        (void)expand;
+        return functions;
+    }
+
+    TaskQueue<App>& push(Task<App>&& task) {
+        size_t capacity = tasks.capacity();
+        tasks.push_back(std::move(task));
+        runner->countTasks(1, static_cast<int64_t>((tasks.capacity() - capacity) * sizeof(Task<App>)));
+        schedule();
+        return *this;
+    }
+
+public:
+    int task_id;
+    /// interned name (use getName() to get it as string)
+    taskrunner::symbol::Symbol task_queue_name;
+
+    /// true while this queue is in the ready list or waiting for its deadline
+    bool scheduled = false;
+
+    /// sync group index (-1 if not a member)
+    int sync_group = -1;
+    /// true if the wait at cursor has arrived at the barrier (and waits for sync_generation)
+    bool sync_arrived = false;
+    uint64_t sync_generation = 0;
+
+    /// state of the async task at cursor
+    bool async_running = false;
+    bool async_done = false;
+
+    /// true when the event which the step at cursor waits for was notified
+    bool event_notified = false;
+
+    /// join step at cursor (then_all() / then_any()): number of children which have not finished yet
+    uint32_t join_remaining = 0;
+    /// incremented by each join step, so children of a finished join don't count for the next one
+    uint32_t join_sequence = 0;
+    bool join_any = false;
+    /// latest timeline of the finished children (where this queue continues in drift-free mode)
+    taskrunner::clock::nanoseconds join_timeline = 0;
+    /// task queue whose join step waits for this one (and its join_sequence then)
+    TaskQueueHandle join_parent;
+    uint32_t joined_sequence = 0;
+
+    /// run of TaskGraph which created this queue for its node (see ofxTaskRunner::runGraph())
+    TaskGraphRunHandle graph_run;
+    uint32_t graph_node = 0;
+
+    /// row of the running tween step in the tween table of the runner
+    uint32_t tween_row = taskrunner::tween::TweenTable::invalid_row;
+
+    /// last parallel advancement which picked this queue (a queue listed twice is advanced once on workers)
+    uint32_t advance_stamp = 0;
+
+    /// true while an update callback of this queue waits to be run under the update budget
+    /// (the queue doesn't advance until it ran, see ofxTaskRunner::setUpdateBudget())
+    bool parked = false;
+
+    /// true after ofxTaskRunner::cancel() (remaining steps are not run, reclaimed on next update)
+    bool cancelled = false;
+    /// true after reclaim while children (or then_create_task_queue() steps collected for update()) remain:
+    /// the queue is kept as a tombstone so cancel() still reaches them, and is erased with its last child
+    bool finished = false;
+    /// then_create_task_queue() steps collected for update() which will link a child to this queue
+    uint32_t pending_child_count = 0;
+    /// maintained by ofxTaskRunner
+    TaskQueueLinks links;
+
+    TaskQueue(ofxTaskRunner<App>* runner, TaskQueueHandle handle, int task_id, taskrunner::symbol::Symbol task_queue_name)
+        : tasks(taskrunner::memory::makeVector<Task<App>>(runner->getMemoryResource())) {
+        this->runner = runner;
+        this->_handle = handle;
+        this->task_id = task_id;
+        this->task_queue_name = task_queue_name;
+    }
+
+    ~TaskQueue() {
+        runner->countTasks(-static_cast<int64_t>(size()), -static_cast<int64_t>(tasks.capacity() * sizeof(Task<App>)));
+    }
+
+    /// name of this queue (for logging / debugging)
+    std::string getName() const {
+        return task_queue_name.str();
+    }
+
+    /// handle to get this queue later (by ofxTaskRunner::getTaskQueue())
+    TaskQueueHandle handle() const {
+        return this->_handle;
+    }
+
+    /// token to cancel this queue (and the queues created by it) later, e.g. when leaving a scene
+    CancelToken<App> getCancelToken() const {
+        return CancelToken<App>(*runner, _handle);
+    }
+
+    /// not movable (the destructor counts the remaining tasks, and slot_map never moves its elements)
+    TaskQueue(TaskQueue&&) = delete;
+    TaskQueue& operator=(TaskQueue&&) = delete;
+
+    TaskQueue(const TaskQueue&) = delete;
+    TaskQueue& operator=(const TaskQueue&) = delete;
+
+    /// number of remaining tasks
+    size_t size() const {
+        return tasks.size() - cursor;
+    }
+
+    bool hasTasks() const {
+        return cursor < tasks.size();
+    }
+
+    Task<App>& front() {
+        return tasks[cursor];
+    }
+
+    /// (the runner counts popped tasks, this may run on a worker thread)
+    void pop_front() {
+        if (!hasTasks()) {
+            return;
+        }
+        cursor++;
+        resetStepState();
+
+        if (cursor == tasks.size()) {
+            // all done, reuse storage
+            tasks.clear();
+            cursor = 0;
+            loop_start = 0;
+        }else if (cursor >= 64 && cursor * 2 >= tasks.size()) {
+            // drop consumed tasks (for long-lived queues which are extended continuously)
+            tasks.erase(tasks.begin(), tasks.begin() + cursor);
+            loop_start = loop_start > cursor ? loop_start - cursor : 0;
+            cursor = 0;
+        }
+    }
+
+    taskrunner::optional::optional<TaskType> getFirstTaskType() const {
+        if (!hasTasks()) {
+            return taskrunner::optional::none;
+        }
+        return tasks[cursor].getTaskType();
+    }
+
+    /// start the wait task at cursor
+    void startWait(taskrunner::clock::nanoseconds now, taskrunner::clock::nanoseconds wait_time) {
+        wait_deadline = now + wait_time;
+        wait_started = true;
+    }
+
+    /// clear state of the current step (when it finished)
+    void resetStepState() {
+        wait_started = false;
+        sync_arrived = false;
+        async_running = false;
+        async_done = false;
+        event_notified = false;
+    }
+
+    bool isWaitStarted() const {
+        return wait_started;
+    }
+
+    /// time (runner's clock) when the wait task at cursor will be done
+    taskrunner::clock::nanoseconds getWaitDeadline() const {
+        return wait_deadline;
+    }
+
+    /// @brief drift-free mode: each wait's deadline is computed from the previous deadline (not from the
+    /// frame which reached it), and overdue waits are caught up within one update(), so long sequences stay
+    /// locked to the clock under frame drops. (default: ofxTaskRunner::setDriftFree())
+    TaskQueue<App>& drift_free(bool enabled = true) {
+        _drift_free = enabled;
+        return *this;
+    }
+
+    bool isDriftFree() const {
+        return _drift_free;
+    }
+
+    /// @brief time where the next wait starts
+    taskrunner::clock::nanoseconds getWaitStartTime(taskrunner::clock::nanoseconds now) const {
+        return getWaitStartTime(now, _drift_free);
+    }
+
+    taskrunner::clock::nanoseconds getWaitStartTime(taskrunner::clock::nanoseconds now, bool drift_free) const {
+        if (drift_free && timeline_started) {
+            return timeline;
+        }
+        return now;
+    }
+
+    /// @brief record end of the wait at cursor (start of the next one in drift-free mode)
+    void setTimeline(taskrunner::clock::nanoseconds time) {
+        timeline = time;
+        timeline_started = true;
+    }
+
+    /// add wait task (in nanoseconds)
+    TaskQueue<App>& wait_ns(taskrunner::clock::nanoseconds wait_time, bool need_sync = false) {
+        if (need_sync) {
+            runner->joinSyncGroup(*this);
+        }
+        bool is_first_task = !hasTasks();
+        push(WaitTask(wait_time, need_sync));
+        if (is_first_task) {
+            startWait(getWaitStartTime(runner->getClock().now()), wait_time);
+        }
+        return *this;
+    }
+
+    /// add wait task (in seconds)
+    TaskQueue<App>& wait_sec(double wait_time_sec, bool need_sync = false) {
+        return wait_ns(taskrunner::clock::fromSec(wait_time_sec), need_sync);
+    }
+
+    /// add wait task (in milliseconds)
+    TaskQueue<App>& wait_ms(double wait_time_millis, bool need_sync = false) {
+        return wait_ns(taskrunner::clock::fromMillis(wait_time_millis), need_sync);
+    }
+
+    /// add sync wait task (in seconds)
+    TaskQueue<App>& wait_sync_sec(double wait_time_sec) {
+        return wait_sec(wait_time_sec, true);
+    }
+
+    /// add sync wait task (in milliseconds)
+    TaskQueue<App>& wait_sync_ms(double wait_time_millis) {
+        return wait_ms(wait_time_millis, true);
+    }
+
+    /// @brief wait until ofxTaskRunner::notify() of the channel is called (e.g. "video_finished").
+    /// the queue is parked without per-frame cost. notifies before the queue reached this step are not remembered
+    TaskQueue<App>& wait_for_event(taskrunner::symbol::Symbol channel) {
+        return push(EventWaitTask(channel));
+    }
+
+    TaskQueue<App>& wait_for_event(const std::string& channel) {
+        return wait_for_event(taskrunner::symbol::intern(channel));
+    }
+
+    /// @brief wait until predicate returns true. it is checked when the step is reached, and then once per
+    /// interval (not every frame), so many parked queues don't add frame time
+    /// @param interval_sec time between checks
+    TaskQueue<App>& wait_until(PredicateFunction<App> predicate, double interval_sec = 0.1) {
+        return push(WaitUntilTask<App>(std::move(predicate), taskrunner::clock::fromSec(interval_sec)));
+    }
+
+    /// @brief animate *target from `from` to `to` over the duration (in seconds), then continue.
+    /// all running tweens are evaluated in one batch per update() (no callback per frame).
+    /// target must stay valid until the tween finished (or the queue is cancelled)
+    TaskQueue<App>& tween(double duration_sec, float* target, float from, float to, taskrunner::tween::Easing easing = taskrunner::tween::Easing::LINEAR) {
+        return tween_ns(taskrunner::clock::fromSec(duration_sec), target, from, to, easing);
+    }
+
+    /// tween() in milliseconds
+    TaskQueue<App>& tween_ms(double duration_millis, float* target, float from, float to, taskrunner::tween::Easing easing = taskrunner::tween::Easing::LINEAR) {
+        return tween_ns(taskrunner::clock::fromMillis(duration_millis), target, from, to, easing);
+    }
+
+    /// tween() in nanoseconds
+    TaskQueue<App>& tween_ns(taskrunner::clock::nanoseconds duration, float* target, float from, float to, taskrunner::tween::Easing easing = taskrunner::tween::Easing::LINEAR) {
+        if (target == nullptr) {
+            taskrunner::adapter::LogError("ofxTaskRunner") << "tween() target is null (ignored)";
+            return *this;
+        }
+        bool is_first_task = !hasTasks();
+        push(TweenTask(duration, target, from, to, easing));
+        if (is_first_task) {
+            startWait(getWaitStartTime(runner->getClock().now()), duration);
+        }
+        return *this;
+    }
+
+    /// add draw task
+    TaskQueue<App>& then_on_draw(TaskFunction<App> draw_task) {
+        return push(DrawTask<App>(std::move(draw_task)));
+    }
+
+    /// add update task (TaskPriority::CRITICAL tasks are never deferred by the update budget)
+    TaskQueue<App>& then_on_update(TaskFunction<App> update_task, TaskPriority priority = TaskPriority::NORMAL) {
+        return push(UpdateTask<App>(std::move(update_task), priority));
+    }
+    
+    /// add update task (alias)
+    TaskQueue<App>& then(TaskFunction<App> update_task, TaskPriority priority = TaskPriority::NORMAL) {
+        return this->then_on_update(std::move(update_task), priority);
+    }
+
+    /// add task which create new task queue
+    TaskQueue<App>& then_create_task_queue(taskrunner::symbol::Symbol task_queue_name, CreateTaskQueueFunction<App> func_for_new_task_queue) {
+        return push(CreateTaskQueueTask<App>(task_id, task_queue_name, _handle, std::move(func_for_new_task_queue)));
+    }
+
+    /// @brief start child task queues on the same update, and wait until all of them finished (or were cancelled).
+    /// children are created with anonymous names (not sync group members), are cancelled with this queue,
+    /// and start from the timeline of this queue. this queue continues from the latest end of them
+    /// @param children build steps of each child, e.g. [](TaskQueue<ofApp>& q) { q.wait_sec(1).then(...); }
+    TaskQueue<App>& then_all(std::vector<CreateTaskQueueFunction<App>> children) {
+        return push(JoinTask<App>(std::move(children), false));
+    }
+
+    template <typename... F>
+    TaskQueue<App>& then_all(F... children) {
+        return then_all(makeChildren(std::move(children)...));
+    }
+
+    /// @brief like then_all(), but continue when the first child finished (the other children are cancelled)
+    TaskQueue<App>& then_any(std::vector<CreateTaskQueueFunction<App>> children) {
+        return push(JoinTask<App>(std::move(children), true));
+    }
+
+    template <typename... F>
+    TaskQueue<App>& then_any(F... children) {
+        return then_any(makeChildren(std::move(children)...));
+    }
+
+    /// @brief run steps of program (built by TaskProgram::build()). O(1), steps are shared with other instances
+    /// @param param passed to step functions (e.g. index of fixture)
+    TaskQueue<App>& then_program(TaskProgramRef<App> program, int param = 0) {
+        if (!program) {
+            taskrunner::adapter::LogError("ofxTaskRunner") << "then_program() program is null (ignored)";
+            return *this;
+        }
+        bool is_first_task = !hasTasks();
+        bool starts_with_wait = program->size() > 0 && program->at(0).type == ProgramStepType::WAIT;
+        taskrunner::clock::nanoseconds wait_time = starts_with_wait ? program->at(0).wait_time : 0;
+        if (program->hasSyncWait()) {
+            runner->joinSyncGroup(*this);
+        }
+        push(ProgramTask<App>(std::move(program), param));
+        if (is_first_task && starts_with_wait) {
+            startWait(getWaitStartTime(runner->getClock().now()), wait_time);
+        }
+        return *this;
+    }
+
+    /// @brief run the steps since previous repeat() / loop() (or the first step) count times in total
+    /// (0 is an error: the steps run once, use loop() to run them forever).
+    /// steps are moved into a TaskProgram, and rerun by rewinding its cursor (only wait and then steps can be repeated)
+    TaskQueue<App>& repeat(uint32_t count) {
+        if (count == 0) {
+            taskrunner::adapter::LogError("ofxTaskRunner") << "repeat(0) is not supported (the steps run once, use loop() to run them forever)";
+            loop_start = tasks.size();
+            return *this;
+        }
+        return repeatSteps(count);
+    }
+
+    /// @brief run the steps since previous repeat() / loop() (or the first step) forever (see repeat())
+    TaskQueue<App>& loop() {
+        return repeatSteps(0);
+    }
+
+    /// @brief call update_task every period (drift-free, even if this queue is not).
+    /// steps after this run when it finished (never for count = 0)
+    /// @param count number of calls (0: forever)
+    TaskQueue<App>& every_ms(double period_millis, TaskFunction<App> update_task, uint32_t count = 0) {
+        TaskProgram<App> program;
+        program.pushEvery(period_millis, std::move(update_task), count);
+        then_program(program.build());
+        loop_start = tasks.size();
+        return *this;
+    }
+
+    /// @brief name the last added step in trace (see ofxTaskRunner::startTrace()). ignored without OFX_TASKRUNNER_TRACE
+    TaskQueue<App>& label(const std::string& label) {
+#ifdef OFX_TASKRUNNER_TRACE
+        if (tasks.size() > cursor) {
+            tasks.back().label = taskrunner::symbol::intern(label);
+        }
+#else
+        (void)label;
+#endif
+        return *this;
+    }
+
+    /// @brief add task which runs on a worker thread. this queue waits (without blocking update())
+    /// until it finished, and the rest of the tasks continue on the main thread
+    TaskQueue<App>& then_async(taskrunner::functional::unique_function<void()> async_task) {
+        return push(AsyncTask(std::move(async_task)));
+    }
+
+    /// @brief add task which runs on a worker thread, and pass its result to on_done (called on update)
+    /// @param async_task returns result (e.g. []() { return loadJson(); })
+    /// @param on_done void(App&, Result&) (not called if async_task threw exception)
+    template <typename F, typename G>
+    TaskQueue<App>& then_async(F async_task, G on_done) {
+        using Result = typename std::decay<decltype(async_task())>::type;
+        auto result = std::make_shared<taskrunner::optional::optional<Result>>();
+
+        then_async([async_task = std::move(async_task), result]() mutable {
+            *result = async_task();
+        });
+        return then_on_update([on_done = std::move(on_done), result](App& app) mutable {
+            if (*result) {
+                on_done(app, **result);
+            }
+        });
+    }
+
+    /// add task which create new task queue (name is interned here, not when the queue is created)
+    TaskQueue<App>& then_create_task_queue(const std::string& task_queue_name, CreateTaskQueueFunction<App> func_for_new_task_queue) {
+        return then_create_task_queue(taskrunner::symbol::intern(task_queue_name), std::move(func_for_new_task_queue));
+    }
+};
+
+// ================================================
+// ================================================
+// ================================================
+
+template <typename App>
+class ofxTaskRunner {
+private:
+public:
+    ~ofxTaskRunner() {
+        // leave shared sync groups
+        clearTaskQueues();
+    }
+
+    void setup(App& app) {
+        this->_should_end = false;
+
+        clearTaskQueues();
+        update_tasks.clear();
+        critical_update_tasks.clear();
+        draw_tasks.clear();
+        create_task_queue_tasks.clear();
+
+        this->app = app;
+    }
+
+    /// @brief register task id at setup (need to detect all tasks are done for sync)
+    /// @param task_id 
+    void registerTaskId(int task_id) {
+        sync_groups->registerTaskId(task_id);
+    }
+
+    /// @brief use other sync groups (default: taskrunner::sync::SyncGroups::shared(),
+    /// or taskrunner::sync::SharedMemorySyncGroups to sync with other processes). call this before creating task queues
+    void setSyncGroups(taskrunner::sync::SyncBackend& sync_groups) {
+        this->sync_groups = &sync_groups;
+    }
+
+    taskrunner::sync::SyncBackend& getSyncGroups() {
+        return *sync_groups;
+    }
+
+    /// @brief number of worker threads for TaskQueue::then_async() (call before the first async task starts)
+    void setAsyncThreadCount(size_t thread_count) {
+        async_thread_count = thread_count;
+    }
+
+    /// @brief default of TaskQueue::drift_free() for task queues created after this call
+    void setDriftFree(bool drift_free) {
+        this->drift_free = drift_free;
+    }
+
+    bool isDriftFree() const {
+        return drift_free;
+    }
+
+#ifdef OFX_TASKRUNNER_PMR
+    /// @brief allocate the per-queue step storage (steps of new task queues) from resource
+    /// (default: std::pmr::get_default_resource()), e.g. std::pmr::unsynchronized_pool_resource to reuse the
+    /// storage of finished queues, with std::pmr::null_memory_resource() upstream to keep the steps in a fixed
+    /// budget (exceeding it throws std::bad_alloc). only the steps: the scheduler containers (queue slots,
+    /// ready / processing lists, pending callbacks, join children) and captures over 48 bytes still use the
+    /// global heap. call it when there is no task queue (e.g. before setup()), the resource must outlive the
+    /// task queues allocated from it. only used on the main thread
+    void setMemoryResource(std::pmr::memory_resource& resource) {
+        this->memory_resource = &resource;
+    }
+#endif
+
+    /// resource of task storage (nullptr without std::pmr)
+    taskrunner::memory::memory_resource* getMemoryResource() const {
+        return memory_resource;
+    }
+
+    /// @brief use other clock (default: monotonic clock in nanoseconds, taskrunner::clock::SteadyClock)
+    /// e.g. taskrunner::clock::VirtualClock to advance time manually.
+    /// call this before creating task queues (running waits keep deadlines of the previous clock)
+    void setClock(taskrunner::clock::Clock& clock) {
+        this->clock = &clock;
+    }
+
+    taskrunner::clock::Clock& getClock() {
+        return *clock;
+    }
+
+    void clearTaskQueues() {
+        task_queues.for_each([this](TaskQueue<App>& task_queue) {
+            if (task_queue.sync_group >= 0) {
+                sync_groups->leave(task_queue.sync_group, task_queue.sync_arrived ? task_queue.sync_generation : 0);
+            }
+        });
+        task_queues.clear();
+        finished_task_queue_count = 0;
+        ready_task_queues.clear();
+        wait_deadlines.clear();
+        cancelled_wait_count = 0;
+        task_queues_by_name.clear();
+        task_queues_by_task_id.clear();
+        graph_runs.clear();
+        tweens.clear();
+        for (auto& waiters : event_waiters) {
+            waiters.second.handles.clear();
+        }
+        for (int group : waiting_sync_groups) {
+            sync_waiters[group].handles.clear();
+        }
+        waiting_sync_groups.clear();
+    }
+
+    void clear(){
+        clearTaskQueues();
+        posted_task_queues.consume([](CreateTaskQueueTask<App>&&) {});
+        update_tasks.clear();
+        critical_update_tasks.clear();
+        draw_tasks.clear();
+        create_task_queue_tasks.clear();
+    }
+
+    /// @brief put task queue into the ready list (processed on next update)
+    /// @param task_queue 
+    void scheduleTaskQueue(TaskQueue<App>& task_queue) {
+        if (task_queue.scheduled) {
+            return;
+        }
+        task_queue.scheduled = true;
+        ready_task_queues.push_back(task_queue.handle());
+    }
+
+    /// @brief where advancing task queues puts callbacks, deadlines and wait lateness: the runner itself on the
+    /// main thread, or buffers of a chunk in parallel advancement (see setParallelThreadCount())
+    struct StepOutput {
+        std::vector<PendingTask<App>>* update_tasks;
+        std::vector<PendingTask<App>>* critical_update_tasks;
+        std::vector<PendingTask<App>>* draw_tasks;
+        std::vector<TaskQueueHandle>* ready_task_queues;
+        taskrunner::stats::Histogram* wait_lateness;
+        /// nullptr: push to the deadline heap directly
+        std::vector<std::pair<taskrunner::clock::nanoseconds, TaskQueueHandle>>* wait_deadlines;
+        /// false on workers: a step which touches other state stops advancing the queue (deferred),
+        /// and the main thread continues it
+        bool main_thread;
+        bool deferred = false;
+        /// popped tasks (counted by the main thread after merge)
+        size_t popped_count = 0;
+
+        StepOutput(std::vector<PendingTask<App>>* update_tasks, std::vector<PendingTask<App>>* critical_update_tasks,
+            std::vector<PendingTask<App>>* draw_tasks, std::vector<TaskQueueHandle>* ready_task_queues,
+            taskrunner::stats::Histogram* wait_lateness,
+            std::vector<std::pair<taskrunner::clock::nanoseconds, TaskQueueHandle>>* wait_deadlines, bool main_thread)
+            : update_tasks(update_tasks), critical_update_tasks(critical_update_tasks), draw_tasks(draw_tasks),
+              ready_task_queues(ready_task_queues), wait_lateness(wait_lateness), wait_deadlines(wait_deadlines),
+              main_thread(main_thread) {}
+    };
+
+    StepOutput mainStepOutput() {
+        return StepOutput { &update_tasks, &critical_update_tasks, &draw_tasks, &ready_task_queues, &wait_lateness, nullptr, true };
+    }
+
+    void popTask(TaskQueue<App>& task_queue, StepOutput& out) {
+        task_queue.pop_front();
+        if (out.main_thread) {
+            countTasks(-1, 0);
+        } else {
+            out.popped_count++;
+        }
+    }
+
+    void pushDeadline(StepOutput& out, taskrunner::clock::nanoseconds deadline, TaskQueueHandle handle) {
+        if (out.wait_deadlines != nullptr) {
+            out.wait_deadlines->emplace_back(deadline, handle);
+        } else {
+            wait_deadlines.push(deadline, handle);
+        }
+    }
+
+    /// @brief advance the task queue until it waits or has no tasks (or, on a worker, until a step which needs the main thread)
+    void processTaskQueue(TaskQueue<App>& task_queue, taskrunner::clock::nanoseconds now, StepOutput& out) {
+        if (task_queue.parked) {
+            return;
+        }
+        while (task_queue.hasTasks()) {
+            Task<App>& task = task_queue.front();
+
+            TaskType type = task.getTaskType();
+            if (!out.main_thread && type != TaskType::WAIT && type != TaskType::DRAW && type != TaskType::UPDATE && type != TaskType::PROGRAM) {
+                out.deferred = true;
+                return;
+            }
+            switch (type) {
+                case TaskType::WAIT:
+                    if (!processWait(task_queue, task.wait.wait_time, task.wait.need_sync, now, out)) {
+                        return;
+                    }
+                    popTask(task_queue, out);
+                    break;
+                // consumed tasks are moved out (never copied)
+                case TaskType::DRAW:
+                    out.draw_tasks->push_back(makePendingTask(task_queue, task.getLabel(), std::move(task.draw.draw_task)));
+                    popTask(task_queue, out);
+                    break;
+                case TaskType::UPDATE: {
+                    bool parked = pushUpdateTask(out, task_queue, makePendingTask(task_queue, task.getLabel(), std::move(task.update.update_task)), task.update.priority);
+                    popTask(task_queue, out);
+                    if (parked) {
+                        return;
+                    }
+                    break;
+                }
+                case TaskType::CREATE_TASK_QUEUE:
+                    create_task_queue_tasks.push_back(std::move(task.create_task_queue));
+                    task_queue.pending_child_count++;
+                    popTask(task_queue, out);
+                    break;
+                case TaskType::ASYNC:
+                    if (task_queue.async_done) {
+                        popTask(task_queue, out);
+                        break;
+                    }
+                    if (!task_queue.async_running) {
+                        task_queue.async_running = true;
+                        startAsyncTask(task_queue, task);
+                    }
+                    // resumed when the worker finished
+                    return;
+                case TaskType::TWEEN:
+                    if (!processTween(task_queue, task.tween, now)) {
+                        return;
+                    }
+                    popTask(task_queue, out);
+                    break;
+                case TaskType::WAIT_EVENT:
+                    if (!processEventWait(task_queue, task.wait_event.channel, now)) {
+                        return;
+                    }
+                    popTask(task_queue, out);
+                    break;
+                case TaskType::WAIT_UNTIL:
+                    if (!task.wait_until.predicate(*app)) {
+                        // check again after the interval (sleeps on the deadline heap like a wait)
+                        wait_deadlines.push(now + std::max<taskrunner::clock::nanoseconds>(task.wait_until.interval, 1), task_queue.handle());
+                        return;
+                    }
+                    task_queue.setTimeline(now);
+                    popTask(task_queue, out);
+                    break;
+                case TaskType::JOIN:
+                    if (!processJoin(task_queue, task.join, now)) {
+                        return;
+                    }
+                    task_queue.setTimeline(task_queue.join_timeline);
+                    popTask(task_queue, out);
+                    break;
+                case TaskType::PROGRAM: {
+                    bool advanced = processProgramStep(task_queue, task.program, now, out);
+                    // (also when parked on the last step)
+                    if (task.program.step >= task.program.program->size()) {
+                        popTask(task_queue, out);
+                    }
+                    if (!advanced) {
+                        return;
+                    }
+                    break;
+                }
+            }
+        }
+
+        // finished (scheduled again when new task is added)
+        task_queue.scheduled = false;
+    }
+
+    bool isUpdateBudgetExceeded(taskrunner::clock::nanoseconds budget_start, size_t processed_count) {
+        if (processed_count == 0) {
+            return false;
+        }
+        if (update_budget_tasks > 0 && processed_count >= update_budget_tasks) {
+            return true;
+        }
+        return update_budget > 0 && steady_clock.now() - budget_start >= update_budget;
+    }
+
+    /// @brief wait step (WaitTask, or wait of TaskProgram)
+    /// @return true when finished (false: sleeping until deadline, or waiting for sync release)
+    bool processWait(TaskQueue<App>& task_queue, taskrunner::clock::nanoseconds wait_time, bool need_sync, taskrunner::clock::nanoseconds now, StepOutput& out, bool drift_free = false) {
+        if (!out.main_thread && (task_queue.sync_arrived || (need_sync && task_queue.sync_group >= 0))) {
+            // (sync groups are shared)
+            out.deferred = true;
+            return false;
+        }
+        drift_free = drift_free || task_queue.isDriftFree();
+        if (task_queue.sync_arrived) {
+            if (!sync_groups->isReleased(task_queue.sync_group, task_queue.sync_generation)) {
+                parkSyncWait(task_queue);
+                return false;
+            }
+            // all members continue from the same time
+            task_queue.setTimeline(std::max(task_queue.getWaitDeadline(), sync_groups->getReleaseTime(task_queue.sync_group)));
+            return true;
+        }
+        if (!task_queue.isWaitStarted()) {
+            task_queue.startWait(task_queue.getWaitStartTime(now, drift_free), wait_time);
+            // (overdue wait in drift-free mode is done on this update)
+            if (!drift_free || task_queue.getWaitDeadline() > now) {
+                // sleep until deadline
+                pushDeadline(out, task_queue.getWaitDeadline(), task_queue.handle());
+                return false;
+            }
+        }else if (now < task_queue.getWaitDeadline()) {
+            pushDeadline(out, task_queue.getWaitDeadline(), task_queue.handle());
+            return false;
+        }
+        out.wait_lateness->add(now - task_queue.getWaitDeadline());
+
+        if (need_sync && task_queue.sync_group >= 0) {
+            task_queue.sync_arrived = true;
+            task_queue.sync_generation = sync_groups->arrive(task_queue.sync_group, task_queue.getWaitDeadline());
+            // released by this arrival: other members resume on this frame too
+            wakeSyncWaiters(task_queue.sync_group);
+            return processWait(task_queue, wait_time, need_sync, now, out, drift_free);
+        }
+        task_queue.setTimeline(task_queue.getWaitDeadline());
+        return true;
+    }
+
+    struct EventWaiters {
+        std::vector<TaskQueueHandle> handles;
+        /// size at which handles of finished or cancelled task queues are pruned on next add
+        /// (doubled after each prune, so a channel which is rarely notified doesn't grow without bound)
+        size_t prune_size = 16;
+    };
+
+    /// @brief event wait step (parked in event_waiters until notify())
+    /// @return true when the event was notified
+    bool processEventWait(TaskQueue<App>& task_queue, taskrunner::symbol::Symbol channel, taskrunner::clock::nanoseconds now) {
+        if (!task_queue.event_notified) {
+            EventWaiters& waiters = event_waiters[channel.id()];
+            if (waiters.handles.size() >= waiters.prune_size) {
+                pruneEventWaiters(waiters);
+            }
+            waiters.handles.push_back(task_queue.handle());
+            return false;
+        }
+        task_queue.setTimeline(now);
+        return true;
+    }
+
+    /// @brief drop handles of task queues which were cancelled or reclaimed while waiting (keeps the order)
+    void pruneEventWaiters(EventWaiters& waiters) {
+        auto stale = [this](TaskQueueHandle handle) {
+            const TaskQueue<App>* task_queue = task_queues.get(handle);
+            return task_queue == nullptr || task_queue->finished || task_queue->cancelled;
+        };
+        waiters.handles.erase(std::remove_if(waiters.handles.begin(), waiters.handles.end(), stale), waiters.handles.end());
+        waiters.prune_size = std::max<size_t>(16, waiters.handles.size() * 2);
+    }
+
+    /// @brief add task queue (not scheduled yet)
+    TaskQueue<App>& emplaceTaskQueue(int task_id, taskrunner::symbol::Symbol name, TaskQueueHandle parent) {
+        TaskQueueHandle handle = task_queues.emplace(this, task_queues.next_key(), task_id, name);
+        TaskQueue<App>& task_queue = *task_queues.get(handle);
+        task_queue.drift_free(drift_free);
+        linkTaskQueue(task_queue, parent);
+        max_task_queue_count = std::max(max_task_queue_count, task_queues.size());
+        return task_queue;
+    }
+
+    /// @brief create task queue while processing task queues, which is processed on this update
+    /// (createTaskQueue() schedules it for next update)
+    TaskQueue<App>& spawnTaskQueue(int task_id, taskrunner::symbol::Symbol name, TaskQueueHandle parent) {
+        TaskQueue<App>& task_queue = emplaceTaskQueue(task_id, name, parent);
+        task_queue.scheduled = true;
+        processing_task_queues.push_back(task_queue.handle());
+        return task_queue;
+    }
+
+    /// @brief join step. children are created on the first visit and processed on this update (appended to
+    /// the processing list), then this queue parks until finishJoinChild() counted them down
+    /// @return true when finished
+    bool processJoin(TaskQueue<App>& task_queue, JoinTask<App>& join, taskrunner::clock::nanoseconds now) {
+        if (join.started) {
+            return task_queue.join_remaining == 0;
+        }
+        join.started = true;
+        task_queue.join_sequence++;
+        task_queue.join_remaining = static_cast<uint32_t>(join.children.size());
+        task_queue.join_any = join.any;
+        task_queue.join_timeline = task_queue.getWaitStartTime(now, true);
+        if (join.children.empty()) {
+            return true;
+        }
+
+        // (slot_map storage is stable, task_queue stays valid while children are created)
+        for (auto& build_child : join.children) {
+            TaskQueue<App>& child = spawnTaskQueue(task_queue.task_id, taskrunner::symbol::SymbolTable::shared().anonymous(), task_queue.handle());
+            child.drift_free(task_queue.isDriftFree());
+            child.setTimeline(task_queue.join_timeline);
+            child.join_parent = task_queue.handle();
+            child.joined_sequence = task_queue.join_sequence;
+            build_child(child);
+        }
+        join.children.clear();
+        return false;
+    }
+
+    /// @brief count down the join of the parent when a child finished (or was cancelled),
+    /// and resume the parent on this update when the join is done
+    void finishJoinChild(TaskQueue<App>& child, taskrunner::clock::nanoseconds now) {
+        TaskQueue<App>* parent = task_queues.get(child.join_parent);
+        if (parent == nullptr || parent->join_sequence != child.joined_sequence || parent->join_remaining == 0) {
+            return;
+        }
+        if (!child.cancelled) {
+            parent->join_timeline = std::max(parent->join_timeline, child.getWaitStartTime(now, true));
+        }
+        parent->join_remaining--;
+        if (parent->join_any && !child.cancelled) {
+            parent->join_remaining = 0;
+            // cancel the other children of this join (children of earlier joins have other sequences)
+            for (TaskQueueHandle handle = parent->links.first_child; task_queues.contains(handle); ) {
+                TaskQueue<App>& sibling = *task_queues.get(handle);
+                handle = sibling.links.siblings.next;
+                if (sibling.joined_sequence == child.joined_sequence && sibling.join_parent == child.join_parent && &sibling != &child) {
+                    cancelTree(sibling.handle());
+                }
+            }
+        }
+        if (parent->join_remaining == 0 && !parent->cancelled) {
+            processing_task_queues.push_back(parent->handle());
+        }
+    }
+
+    /// @brief release the dependents of a finished graph node (in-degree counters), and start the ones
+    /// whose dependencies all finished on this update. cancelled nodes release nothing
+    void finishGraphNode(TaskQueue<App>& task_queue, taskrunner::clock::nanoseconds now) {
+        TaskGraphRunHandle run_handle = task_queue.graph_run;
+        GraphRun& run = *graph_runs.get(run_handle);
+        run.node_queues[task_queue.graph_node] = TaskQueueHandle();
+        run.running_count--;
+
+        if (!task_queue.cancelled && !run.cancelled) {
+            taskrunner::clock::nanoseconds finish_time = task_queue.getWaitStartTime(now, true);
+            const TaskGraph<App>& graph = *run.graph;
+            for (const auto* it = graph.successorsBegin(task_queue.graph_node); it != graph.successorsEnd(task_queue.graph_node); ++it) {
+                run.start_times[*it] = std::max(run.start_times[*it], finish_time);
+                if (--run.remaining[*it] == 0) {
+                    startGraphNode(run_handle, *it, true);
+                }
+            }
+        }
+        if (run.running_count == 0) {
+            graph_runs.erase(run_handle);
+        }
+    }
+
+    /// @brief create the task queue of a graph node
+    /// @param immediate processed on this update (while processing task queues), otherwise on next update
+    void startGraphNode(TaskGraphRunHandle run_handle, typename TaskGraph<App>::NodeId node_id, bool immediate) {
+        GraphRun& run = *graph_runs.get(run_handle);
+        const auto& node = run.graph->at(node_id);
+        TaskQueue<App>& task_queue = immediate ? spawnTaskQueue(node.task_id, node.name, TaskQueueHandle()) : createTaskQueue(node.task_id, node.name);
+        // (drift-free node continues from the latest end of its dependencies)
+        if (run.graph->getInDegrees()[node_id] > 0) {
+            task_queue.setTimeline(run.start_times[node_id]);
+        }
+        task_queue.graph_run = run_handle;
+        task_queue.graph_node = node_id;
+        run.node_queues[node_id] = task_queue.handle();
+        run.running_count++;
+        if (node.program) {
+            task_queue.then_program(node.program, node.param);
+        }
+    }
+
+    /// @brief tween step. the value is written by evaluateTweens() while the queue sleeps until the end
+    /// @return true when finished
+    bool processTween(TaskQueue<App>& task_queue, TweenTask& tween, taskrunner::clock::nanoseconds now) {
+        if (!task_queue.isWaitStarted()) {
+            task_queue.startWait(task_queue.getWaitStartTime(now, task_queue.isDriftFree()), tween.duration);
+        }
+        if (now < task_queue.getWaitDeadline()) {
+            if (task_queue.tween_row == taskrunner::tween::TweenTable::invalid_row) {
+                task_queue.tween_row = tweens.add(task_queue.handle(), tween.target, tween.from, tween.to, tween.easing,
+                    task_queue.getWaitDeadline() - tween.duration, task_queue.getWaitDeadline(), now);
+            }
+            wait_deadlines.push(task_queue.getWaitDeadline(), task_queue.handle());
+            return false;
+        }
+        *tween.target = tween.to;
+        task_queue.setTimeline(task_queue.getWaitDeadline());
+        return true;
+    }
+
+    /// remove the running tween of the task queue from the tween table
+    void removeTween(TaskQueue<App>& task_queue) {
+        if (task_queue.tween_row == taskrunner::tween::TweenTable::invalid_row) {
+            return;
+        }
+        tweens.remove(task_queue.tween_row, [this](TaskQueueHandle owner, uint32_t row) {
+            task_queues.get(owner)->tween_row = row;
+        });
+        task_queue.tween_row = taskrunner::tween::TweenTable::invalid_row;
+    }
+
+    /// write values of running tweens (finished ones are removed, their queues wake up by deadline)
+    void evaluateTweens(taskrunner::clock::nanoseconds now) {
+        tweens.evaluate(now, [this](TaskQueueHandle owner) {
+            if (TaskQueue<App>* task_queue = task_queues.get(owner)) {
+                task_queue->tween_row = taskrunner::tween::TweenTable::invalid_row;
+            }
+        }, [this](TaskQueueHandle owner, uint32_t row) {
+            if (TaskQueue<App>* task_queue = task_queues.get(owner)) {
+                task_queue->tween_row = row;
+            }
+        });
+    }
+
+    /// @brief run current step of program instance (steps are shared, so callbacks are called through the program)
+    /// @return true when the step finished (false: waiting, or parked on its update callback)
+    bool processProgramStep(TaskQueue<App>& task_queue, ProgramTask<App>& program_task, taskrunner::clock::nanoseconds now, StepOutput& out) {
+        if (program_task.step >= program_task.program->size()) {
+            return true;
+        }
+
+        if (!program_task.started) {
+            program_task.started = true;
+            // drift-free steps (every_ms()) start from here on queues which are not drift-free
+            if (!task_queue.isDriftFree() && !task_queue.isWaitStarted()) {
+                task_queue.setTimeline(now);
+            }
+        }
+
+        const typename TaskProgram<App>::Step& step = program_task.program->at(program_task.step);
+        switch (step.type) {
+            case ProgramStepType::WAIT:
+                if (!processWait(task_queue, step.wait_time, step.need_sync, now, out, step.drift_free)) {
+                    return false;
+                }
+                break;
+            case ProgramStepType::DRAW:
+                out.draw_tasks->push_back(makePendingTask(task_queue, step.label, programFunction(program_task, step)));
+                break;
+            case ProgramStepType::UPDATE:
+                if (pushUpdateTask(out, task_queue, makePendingTask(task_queue, step.label, programFunction(program_task, step)), step.priority)) {
+                    program_task.step++;
+                    task_queue.resetStepState();
+                    return false;
+                }
+                break;
+            case ProgramStepType::WAIT_EVENT:
+                if (!out.main_thread) {
+                    out.deferred = true;
+                    return false;
+                }
+                if (!processEventWait(task_queue, step.channel, now)) {
+                    return false;
+                }
+                break;
+            case ProgramStepType::REPEAT:
+                if (step.repeat_count == 0 || program_task.iteration + 1 < step.repeat_count) {
+                    // rewind (forever loops don't count)
+                    if (step.repeat_count != 0) {
+                        program_task.iteration++;
+                    }
+                    program_task.step = step.jump_to;
+                    task_queue.resetStepState();
+                    if (!step.has_wait) {
+                        // nothing to sleep on: run again on next update (not in this loop)
+                        out.ready_task_queues->push_back(task_queue.handle());
+                        return false;
+                    }
+                    return true;
+                }
+                program_task.iteration = 0;
+                break;
+        }
+
+        program_task.step++;
+        task_queue.resetStepState();
+        return true;
+    }
+
+    /// callback of program step (keeps the program alive until called, without heap allocation)
+    static TaskFunction<App> programFunction(const ProgramTask<App>& program_task, const typename TaskProgram<App>::Step& step) {
+        if (step.task) {
+            const TaskFunction<App>* task = &step.task;
+            return [program = program_task.program, task](App& app) {
+                (*task)(app);
+            };
+        }
+        const ProgramFunction<App>* func = &step.func;
+        int param = program_task.param;
+        return [program = program_task.program, func, param](App& app) {
+            (*func)(app, param);
+        };
+    }
+
+    /// @brief collect update callback. under the update budget, the queue parks on a normal priority callback
+    /// (its following steps, e.g. draws or waits, start after the callback ran: see resumeParkedTaskQueue())
+    /// @return true if the queue parked
+    bool pushUpdateTask(StepOutput& out, TaskQueue<App>& task_queue, PendingTask<App>&& pending_task, TaskPriority priority) {
+        if (priority == TaskPriority::CRITICAL) {
+            out.critical_update_tasks->push_back(std::move(pending_task));
+            return false;
+        }
+        if (hasUpdateBudget()) {
+            pending_task.parked = task_queue.handle();
+            task_queue.parked = true;
+        }
+        out.update_tasks->push_back(std::move(pending_task));
+        return task_queue.parked;
+    }
+
+    PendingTask<App> makePendingTask(const TaskQueue<App>& task_queue, taskrunner::symbol::Symbol label, TaskFunction<App>&& func) {
+        PendingTask<App> pending_task;
+        pending_task.task = std::move(func);
+#ifdef OFX_TASKRUNNER_TRACE
+        pending_task.tag = traceTag(task_queue, label);
+#else
+        (void)task_queue;
+        (void)label;
+#endif
+        return pending_task;
+    }
+
+#ifdef OFX_TASKRUNNER_TRACE
+    taskrunner::trace::TraceTag traceTag(const TaskQueue<App>& task_queue, taskrunner::symbol::Symbol label) const {
+        taskrunner::trace::TraceTag tag;
+        tag.task_queue_name = task_queue.task_queue_name;
+        tag.task_id = task_queue.task_id;
+        tag.label = label;
+        return tag;
+    }
+
+    /// null while not tracing (events are not recorded)
+    taskrunner::trace::TraceBuffer* getActiveTraceBuffer() const {
+        return tracing ? trace_buffer.get() : nullptr;
+    }
+#endif
+
+    void startAsyncTask(const TaskQueue<App>& task_queue, Task<App>& task) {
+        if (!thread_pool) {
+            thread_pool.reset(new taskrunner::async::ThreadPool(async_thread_count));
+        }
+
+        TaskQueueHandle handle = task_queue.handle();
+#ifdef OFX_TASKRUNNER_TRACE
+        taskrunner::trace::TraceTag tag = traceTag(task_queue, task.getLabel());
+        thread_pool->submit([this, handle, tag, async_task = std::move(task.async.async_task)]() {
+            OFX_TASKRUNNER_TRACE_SCOPE(getActiveTraceBuffer(), taskrunner::trace::EventType::ASYNC, tag);
+#else
+        thread_pool->submit([this, handle, async_task = std::move(task.async.async_task)]() {
+#endif
+            try {
+                async_task();
+            } catch (std::exception& e) {
+                taskrunner::adapter::LogError("ofxTaskRunner") << "exception in async task: " << e.what();
+            }
+
+            std::lock_guard<std::mutex> lock(async_mutex);
+            completed_async_tasks.push_back(handle);
+            has_completed_async_tasks.store(true, std::memory_order_release);
+        });
+    }
+
+    /// resume task queues whose async task finished
+    void resumeAsyncTasks() {
+        if (!has_completed_async_tasks.load(std::memory_order_acquire)) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(async_mutex);
+        for (TaskQueueHandle handle : completed_async_tasks) {
+            TaskQueue<App>* task_queue = task_queues.get(handle);
+            if (task_queue != nullptr) {
+                task_queue->async_done = true;
+                processing_task_queues.push_back(handle);
+            }
+        }
+        completed_async_tasks.clear();
+        has_completed_async_tasks.store(false, std::memory_order_relaxed);
+    }
+
+    /// wait until the sync group is released (without polling each task queue)
+    void parkSyncWait(TaskQueue<App>& task_queue) {
+        int group = task_queue.sync_group;
+        if (sync_waiters.size() <= static_cast<size_t>(group)) {
+            sync_waiters.resize(group + 1);
+        }
+
+        SyncWaiters& waiters = sync_waiters[group];
+        if (waiters.handles.empty()) {
+            waiters.generation = task_queue.sync_generation;
+            waiting_sync_groups.push_back(group);
+        }else{
+            waiters.generation = std::min(waiters.generation, task_queue.sync_generation);
+        }
+        waiters.handles.push_back(task_queue.handle());
+    }
+
+    /// @brief resume task queues waiting for the sync group if it is released (on this update)
+    /// @return true if there is no waiter anymore
+    bool wakeSyncWaiters(int group) {
+        if (sync_waiters.size() <= static_cast<size_t>(group)) {
+            return true;
+        }
+
+        SyncWaiters& waiters = sync_waiters[group];
+        if (waiters.handles.empty()) {
+            return true;
+        }
+        if (!sync_groups->isReleased(group, waiters.generation)) {
+            return false;
+        }
+
+        // (waiters which are not released yet park again)
+        processing_task_queues.insert(processing_task_queues.end(), waiters.handles.begin(), waiters.handles.end());
+        waiters.handles.clear();
+        return true;
+    }
+
+    /// process only the task queues which are ready or whose wait deadline has passed
+    void processTaskQueues(){
+        OFX_TASKRUNNER_TRACE_SCOPE(getActiveTraceBuffer(), taskrunner::trace::EventType::PROCESS_TASK_QUEUES, taskrunner::trace::TraceTag());
+
+        // clock is read once per update
+        taskrunner::clock::nanoseconds now = clock->now();
+
+        wait_deadlines.pop_expired(now, [this](TaskQueueHandle handle) {
+            ready_task_queues.push_back(handle);
+        });
+
+        // tasks scheduled while processing are kept for next update
+        processing_task_queues.swap(ready_task_queues);
+
+        resumeAsyncTasks();
+
+        evaluateTweens(now);
+
+        // sync groups released by others (other runners, or members which finished)
+        for (size_t i = 0; i < waiting_sync_groups.size(); ) {
+            if (wakeSyncWaiters(waiting_sync_groups[i])) {
+                waiting_sync_groups[i] = waiting_sync_groups.back();
+                waiting_sync_groups.pop_back();
+            }else{
+                i++;
+            }
+        }
+
+        StepOutput out = mainStepOutput();
+        size_t i = 0;
+        if (parallel_thread_count > 0 && processing_task_queues.size() >= parallel_min_task_queues) {
+            i = advanceInParallel(now, out);
+        }
+        processTaskQueueList(i, now, out);
+        process_now = now;
+
+        compactWaitDeadlines();
+    }
+
+    /// @brief drop the deadlines of reclaimed task queues once cancelled queues may make up half of the heap
+    /// (a cancelled queue leaves its deadline until it passes, so frequent cancels of long waits would pile up).
+    /// O(n), after at least n / 2 cancels
+    void compactWaitDeadlines() {
+        if (cancelled_wait_count < 32 || cancelled_wait_count * 2 < wait_deadlines.size()) {
+            return;
+        }
+        wait_deadlines.remove_if([this](TaskQueueHandle handle) {
+            const TaskQueue<App>* task_queue = task_queues.get(handle);
+            return task_queue == nullptr || task_queue->finished;
+        });
+        cancelled_wait_count = 0;
+    }
+
+    /// advance the task queues in the processing list from begin, then clear it
+    void processTaskQueueList(size_t begin, taskrunner::clock::nanoseconds now, StepOutput& out) {
+        // (task queues released by sync are appended while processing)
+        for (size_t i = begin; i < processing_task_queues.size(); i++) {
+            TaskQueueHandle handle = processing_task_queues[i];
+            TaskQueue<App>* task_queue = task_queues.get(handle);
+            if (task_queue == nullptr) {
+                continue;
+            }
+
+            if (!task_queue->cancelled) {
+                processTaskQueue(*task_queue, now, out);
+            }
+            reclaimIfFinished(handle, *task_queue, now);
+        }
+        processing_task_queues.clear();
+    }
+
+    /// @brief continue the task queue parked on an update callback which just ran (on the time of this update).
+    /// its next callbacks are appended to this update (critical ones run right away)
+    void resumeParkedTaskQueue(TaskQueueHandle handle) {
+        TaskQueue<App>* task_queue = task_queues.get(handle);
+        if (task_queue == nullptr) {
+            return;
+        }
+        task_queue->parked = false;
+        processing_task_queues.push_back(handle);
+        StepOutput out = mainStepOutput();
+        processTaskQueueList(0, process_now, out);
+        runCriticalUpdateTasks();
+    }
+
+    void runCriticalUpdateTasks() {
+        // task is moved out before calling (it may call clear())
+        for (size_t i = 0; i < critical_update_tasks.size(); i++) {
+            auto pending_task = std::move(critical_update_tasks[i]);
+            OFX_TASKRUNNER_TRACE_SCOPE(getActiveTraceBuffer(), taskrunner::trace::EventType::UPDATE, pending_task.tag);
+            pending_task.task(*app);
+        }
+        critical_update_tasks.clear();
+    }
+
+    /// reclaim finished (or cancelled) task queue (its slot is reused once its children are gone)
+    void reclaimIfFinished(TaskQueueHandle handle, TaskQueue<App>& task_queue, taskrunner::clock::nanoseconds now) {
+        if (task_queue.finished || (!task_queue.cancelled && task_queue.hasTasks())) {
+            return;
+        }
+        if (task_queues.contains(task_queue.join_parent)) {
+            finishJoinChild(task_queue, now);
+        }
+        if (graph_runs.contains(task_queue.graph_run)) {
+            finishGraphNode(task_queue, now);
+        }
+        int sync_group = task_queue.sync_group;
+        // (cancelled member may have arrived at the barrier without being released)
+        uint64_t sync_generation = task_queue.sync_arrived ? task_queue.sync_generation : 0;
+        task_queue.sync_group = -1;
+        removeTween(task_queue);
+        unlinkTaskQueue(task_queue);
+        task_queue.finished = true;
+        finished_task_queue_count++;
+        if (task_queue.cancelled) {
+            cancelled_wait_count++;
+        }
+        eraseFinishedTaskQueues(handle);
+        if (sync_group >= 0) {
+            sync_groups->leave(sync_group, sync_generation);
+            wakeSyncWaiters(sync_group);
+        }
+    }
+
+    /// @brief erase the finished task queue if it has no children left, and then its finished ancestors
+    void eraseFinishedTaskQueues(TaskQueueHandle handle) {
+        TaskQueue<App>* task_queue = task_queues.get(handle);
+        while (task_queue != nullptr && task_queue->finished && task_queue->pending_child_count == 0
+            && !task_queues.contains(task_queue->links.first_child)) {
+            TaskQueueHandle parent = task_queue->links.parent;
+            unlinkFromParent(*task_queue);
+            task_queues.erase(handle);
+            finished_task_queue_count--;
+            handle = parent;
+            task_queue = task_queues.get(handle);
+        }
+    }
+
+    /// @brief advance the task queues in the processing list on the parallel workers (chunks of it into
+    /// buffers of each chunk), then merge the buffers on the main thread queue by queue in the list order, continuing
+    /// deferred queues and reclaiming finished ones in between. the result is the same as the serial loop
+    /// @return number of processed entries of the processing list
+    size_t advanceInParallel(taskrunner::clock::nanoseconds now, StepOutput& out) {
+        size_t entry_count = processing_task_queues.size();
+        size_t chunk_count = (entry_count + parallel_chunk_size - 1) / parallel_chunk_size;
+        if (chunk_buffers.size() < chunk_count) {
+            chunk_buffers.resize(chunk_count);
+        }
+        if (!parallel_pool) {
+            parallel_pool.reset(new taskrunner::async::ParallelFor(parallel_thread_count));
+        }
+
+        // workers only touch queues picked here (once each: the list may have duplicates, and cancelled ones are only reclaimed)
+        advance_entries.resize(entry_count);
+        advance_stamp++;
+        for (size_t i = 0; i < entry_count; i++) {
+            AdvanceEntry& entry = advance_entries[i];
+            entry = AdvanceEntry();
+            entry.task_queue = task_queues.get(processing_task_queues[i]);
+            if (entry.task_queue != nullptr && !entry.task_queue->cancelled && entry.task_queue->advance_stamp != advance_stamp) {
+                entry.task_queue->advance_stamp = advance_stamp;
+                entry.on_worker = true;
+            }
+        }
+
+        auto advance_chunk = [this, now, entry_count](size_t chunk) {
+            ChunkBuffer& buffer = chunk_buffers[chunk];
+            StepOutput chunk_out { &buffer.update_tasks, &buffer.critical_update_tasks, &buffer.draw_tasks,
+                &buffer.ready_task_queues, &buffer.wait_lateness, &buffer.wait_deadlines, false };
+            for (size_t i = chunk * parallel_chunk_size; i < std::min(entry_count, (chunk + 1) * parallel_chunk_size); i++) {
+                AdvanceEntry& entry = advance_entries[i];
+                if (!entry.on_worker) {
+                    continue;
+                }
+                size_t update_count = buffer.update_tasks.size();
+                size_t critical_update_count = buffer.critical_update_tasks.size();
+                size_t draw_count = buffer.draw_tasks.size();
+                size_t ready_count = buffer.ready_task_queues.size();
+                size_t deadline_count = buffer.wait_deadlines.size();
+                chunk_out.deferred = false;
+                chunk_out.popped_count = 0;
+                processTaskQueue(*entry.task_queue, now, chunk_out);
+                entry.deferred = chunk_out.deferred;
+                entry.update_count = static_cast<uint32_t>(buffer.update_tasks.size() - update_count);
+                entry.critical_update_count = static_cast<uint32_t>(buffer.critical_update_tasks.size() - critical_update_count);
+                entry.draw_count = static_cast<uint32_t>(buffer.draw_tasks.size() - draw_count);
+                entry.ready_count = static_cast<uint32_t>(buffer.ready_task_queues.size() - ready_count);
+                entry.deadline_count = static_cast<uint32_t>(buffer.wait_deadlines.size() - deadline_count);
+                entry.popped_count = static_cast<uint32_t>(chunk_out.popped_count);
+            }
+        };
+        parallel_pool->run(chunk_count, advance_chunk);
+
+        for (size_t chunk = 0; chunk < chunk_count; chunk++) {
+            ChunkBuffer& buffer = chunk_buffers[chunk];
+            wait_lateness.merge(buffer.wait_lateness);
+            size_t update_cursor = 0;
+            size_t critical_update_cursor = 0;
+            size_t draw_cursor = 0;
+            size_t ready_cursor = 0;
+            size_t deadline_cursor = 0;
+
+            for (size_t i = chunk * parallel_chunk_size; i < std::min(entry_count, (chunk + 1) * parallel_chunk_size); i++) {
+                const AdvanceEntry& entry = advance_entries[i];
+                TaskQueueHandle handle = processing_task_queues[i];
+                countTasks(-static_cast<int64_t>(entry.popped_count), 0);
+                // (may be reclaimed or cancelled by an earlier queue, e.g. then_any(): the serial loop wouldn't advance it)
+                TaskQueue<App>* task_queue = task_queues.get(handle);
+                if (entry.on_worker && task_queue != nullptr && !task_queue->cancelled) {
+                    moveRange(buffer.update_tasks, update_cursor, entry.update_count, update_tasks);
+                    moveRange(buffer.critical_update_tasks, critical_update_cursor, entry.critical_update_count, critical_update_tasks);
+                    moveRange(buffer.draw_tasks, draw_cursor, entry.draw_count, draw_tasks);
+                    moveRange(buffer.ready_task_queues, ready_cursor, entry.ready_count, ready_task_queues);
+                    for (size_t j = deadline_cursor; j < deadline_cursor + entry.deadline_count; j++) {
+                        wait_deadlines.push(buffer.wait_deadlines[j].first, buffer.wait_deadlines[j].second);
+                    }
+                }
+                update_cursor += entry.update_count;
+                critical_update_cursor += entry.critical_update_count;
+                draw_cursor += entry.draw_count;
+                ready_cursor += entry.ready_count;
+                deadline_cursor += entry.deadline_count;
+
+                if (task_queue == nullptr) {
+                    continue;
+                }
+                if (!task_queue->cancelled && (!entry.on_worker || entry.deferred)) {
+                    processTaskQueue(*task_queue, now, out);
+                }
+                reclaimIfFinished(handle, *task_queue, now);
+            }
+            buffer.clear();
+        }
+        return entry_count;
+    }
+
+    template <class T>
+    static void moveRange(std::vector<T>& from, size_t begin, size_t count, std::vector<T>& to) {
+        to.insert(to.end(), std::make_move_iterator(from.begin() + begin), std::make_move_iterator(from.begin() + begin + count));
+    }
+
+    /// @brief add a node to the front of an intrusive list of TaskQueueLinks
+    void linkTaskQueue(TaskQueueHandle& head, TaskQueue<App>& task_queue, TaskQueueLinks::Node TaskQueueLinks::* list) {
+        TaskQueueLinks::Node& node = task_queue.links.*list;
+        node.prev = TaskQueueHandle();
+        node.next = head;
+        if (TaskQueue<App>* next = task_queues.get(head)) {
+            (next->links.*list).prev = task_queue.handle();
+        }
+        head = task_queue.handle();
+    }
+
+    void unlinkTaskQueue(TaskQueueHandle& head, TaskQueue<App>& task_queue, TaskQueueLinks::Node TaskQueueLinks::* list) {
+        TaskQueueLinks::Node& node = task_queue.links.*list;
+        if (TaskQueue<App>* prev = task_queues.get(node.prev)) {
+            (prev->links.*list).next = node.next;
+        } else if (head == task_queue.handle()) {
+            head = node.next;
+        }
+        if (TaskQueue<App>* next = task_queues.get(node.next)) {
+            (next->links.*list).prev = node.prev;
+        }
+        node = TaskQueueLinks::Node();
+    }
+
+    /// index by name (anonymous names are not indexed, they are unique), task_id and parent
+    void linkTaskQueue(TaskQueue<App>& task_queue, TaskQueueHandle parent_handle) {
+        if (!task_queue.task_queue_name.isAnonymous()) {
+            linkTaskQueue(task_queues_by_name[task_queue.task_queue_name.id()], task_queue, &TaskQueueLinks::by_name);
+        }
+        linkTaskQueue(task_queues_by_task_id[task_queue.task_id], task_queue, &TaskQueueLinks::by_task_id);
+        if (TaskQueue<App>* parent = task_queues.get(parent_handle)) {
+            task_queue.links.parent = parent_handle;
+            linkTaskQueue(parent->links.first_child, task_queue, &TaskQueueLinks::siblings);
+        }
+    }
+
+    /// @brief remove from the list in the index, and the entry of the index when the list became empty
+    /// (so the indexes don't grow with the number of names / task ids ever used)
+    template <class Key>
+    void unlinkTaskQueue(std::unordered_map<Key, TaskQueueHandle>& index, Key key, TaskQueue<App>& task_queue, TaskQueueLinks::Node TaskQueueLinks::* list) {
+        auto it = index.find(key);
+        if (it == index.end()) {
+            return;
+        }
+        unlinkTaskQueue(it->second, task_queue, list);
+        if (!task_queues.contains(it->second)) {
+            index.erase(it);
+        }
+    }
+
+    /// remove from the name and task_id indexes (a finished queue stays linked to its parent and children)
+    void unlinkTaskQueue(TaskQueue<App>& task_queue) {
+        if (!task_queue.task_queue_name.isAnonymous()) {
+            unlinkTaskQueue(task_queues_by_name, task_queue.task_queue_name.id(), task_queue, &TaskQueueLinks::by_name);
+        }
+        unlinkTaskQueue(task_queues_by_task_id, task_queue.task_id, task_queue, &TaskQueueLinks::by_task_id);
+    }
+
+    void unlinkFromParent(TaskQueue<App>& task_queue) {
+        TaskQueueHandle no_parent;
+        TaskQueue<App>* parent = task_queues.get(task_queue.links.parent);
+        unlinkTaskQueue(parent != nullptr ? parent->links.first_child : no_parent, task_queue, &TaskQueueLinks::siblings);
+    }
+
+    /// mark the task queue and its descendants cancelled, and put them into the ready list to be reclaimed
+    size_t cancelTree(TaskQueueHandle root) {
+        size_t cancelled_count = 0;
+        cancel_stack.push_back(root);
+        while (!cancel_stack.empty()) {
+            TaskQueueHandle handle = cancel_stack.back();
+            cancel_stack.pop_back();
+
+            TaskQueue<App>* task_queue = task_queues.get(handle);
+            if (task_queue == nullptr || task_queue->cancelled) {
+                continue;
+            }
+            task_queue->cancelled = true;
+            // (a finished queue is only kept for its children: its pending creations are dropped)
+            if (!task_queue->finished) {
+                cancelled_count++;
+                // (the target is not written after cancel, it may be destroyed right away)
+                removeTween(*task_queue);
+                // (also when parked on a deadline or sync wait: those entries are skipped after reclaim)
+                ready_task_queues.push_back(handle);
+            }
+
+            for (TaskQueueHandle child = task_queue->links.first_child; task_queues.contains(child); ) {
+                cancel_stack.push_back(child);
+                child = task_queues.get(child)->links.siblings.next;
+            }
+        }
+        return cancelled_count;
+    }
+
+    /// cancelTree() of each task queue in the list
+    size_t cancelList(TaskQueueHandle head, TaskQueueLinks::Node TaskQueueLinks::* list) {
+        size_t cancelled_count = 0;
+        for (TaskQueueHandle handle = head; task_queues.contains(handle); ) {
+            cancelled_count += cancelTree(handle);
+            handle = (task_queues.get(handle)->links.*list).next;
+        }
+        return cancelled_count;
+    }
+
+    void update() {
+        if (!app) {
+            taskrunner::adapter::LogError("ofxTaskRunner") << "setup() must be called before update()";
+            taskrunner::utils::panic();
+        }
+
+        taskrunner::clock::nanoseconds process_start = steady_clock.now();
+        createPostedTaskQueues();
+        processTaskQueues();
+        taskrunner::clock::nanoseconds budget_start = steady_clock.now();
+        process_time.add(budget_start - process_start);
+
+        // (critical tasks don't count towards max_tasks of the budget, their time does)
+        size_t processed_count = 0;
+
+        runCriticalUpdateTasks();
+
+        // tasks over the budget stay at the front, and run before newer ones on the next frame.
+        // their queues stay parked until then, so steps of a queue keep their order
+        size_t i = 0;
+        for (; i < update_tasks.size(); i++) {
+            if (isUpdateBudgetExceeded(budget_start, processed_count)) {
+                break;
+            }
+            auto pending_task = std::move(update_tasks[i]);
+            {
+                OFX_TASKRUNNER_TRACE_SCOPE(getActiveTraceBuffer(), taskrunner::trace::EventType::UPDATE, pending_task.tag);
+                pending_task.task(*app);
+            }
+            processed_count++;
+            resumeParkedTaskQueue(pending_task.parked);
+        }
+        update_tasks.erase(update_tasks.begin(), update_tasks.begin() + std::min(i, update_tasks.size()));
+
+        size_t j = 0;
+        for (; j < create_task_queue_tasks.size(); j++) {
+            if (isUpdateBudgetExceeded(budget_start, processed_count)) {
+                break;
+            }
+            auto t = std::move(create_task_queue_tasks[j]);
+            OFX_TASKRUNNER_TRACE_SCOPE(getActiveTraceBuffer(), taskrunner::trace::EventType::CREATE_TASK_QUEUE,
+                (taskrunner::trace::TraceTag { t.task_queue_name, t.task_id, taskrunner::symbol::Symbol() }));
+
+            TaskQueue<App>* parent = task_queues.get(t.parent);
+            if (parent == nullptr || !parent->cancelled) {
+                auto&& new_task_queue = createTaskQueue(t.task_id, t.task_queue_name, t.parent);
+                t.func_for_new_task_queue(new_task_queue);
+                // (the callback may have cleared or cancelled the parent)
+                parent = task_queues.get(t.parent);
+            }
+            if (parent != nullptr) {
+                parent->pending_child_count--;
+                eraseFinishedTaskQueues(t.parent);
+            }
+            processed_count++;
         }
+        create_task_queue_tasks.erase(create_task_queue_tasks.begin(), create_task_queue_tasks.begin() + std::min(j, create_task_queue_tasks.size()));
+
+        deferred_task_count = update_tasks.size() + create_task_queue_tasks.size();
+        total_deferred_task_count += deferred_task_count;
     }
 
     void draw() const {
         if (!app) {
-            ofLogError("ofxTaskRunner") << "setup() must be called before draw()";
+            taskrunner::adapter::LogError("ofxTaskRunner") << "setup() must be called before draw()";
             taskrunner::utils::panic();
         }
         
         const auto& app_const = *app;
         auto* self = const_cast<ofxTaskRunner*>(this);
 
-        while (!draw_tasks.empty()) {
-            auto task = self->draw_tasks.front();
-            self->draw_tasks.pop();
-            task(app_const);
+        for (size_t i = 0; i < self->draw_tasks.size(); i++) {
+            auto pending_task = std::move(self->draw_tasks[i]);
+            OFX_TASKRUNNER_TRACE_SCOPE(getActiveTraceBuffer(), taskrunner::trace::EventType::DRAW, pending_task.tag);
+            pending_task.task(app_const);
         }
+        self->draw_tasks.clear();
+    }
+
+    /// @brief create new task queue. returned reference stays valid until the queue finished
+    /// (task queue is removed on update() when it has no tasks, use handle() to check it later)
+    /// @param parent task queue which cancels the new one with it (see cancel())
+    TaskQueue<App>& createTaskQueue(int task_id, taskrunner::symbol::Symbol name, TaskQueueHandle parent = TaskQueueHandle()) {
+        TaskQueue<App>& task_queue = emplaceTaskQueue(task_id, name, parent);
+        scheduleTaskQueue(task_queue);
+        return task_queue;
     }
 
-    TaskQueue<App>& createTaskQueue(int task_id, std::string name) {
-        task_queues.push_back(TaskQueue<App>(task_id, name));
-        return task_queues.back();
+    TaskQueue<App>& createTaskQueue(int task_id, const std::string& name) {
+        return createTaskQueue(task_id, taskrunner::symbol::intern(name));
     }
 
-    TaskQueue<App>& createTaskQueue(std::string name) {
-        task_queues.push_back(TaskQueue<App>(0, name));
-        return task_queues.back();
+    TaskQueue<App>& createTaskQueue(const std::string& name) {
+        return createTaskQueue(0, name);
     }
 
+    /// create task queue with unique anonymous name
     TaskQueue<App>& createTaskQueue() {
-        std::string task_uuid = taskrunner::uuid::generate_uuid_v4();
-        std::string name = "task_queue_" + task_uuid;
-        task_queues.push_back(TaskQueue<App>(0, name));
-        return task_queues.back();
+        return createTaskQueue(0, taskrunner::symbol::SymbolTable::shared().anonymous());
+    }
+
+    /// @brief thread-safe request to create a task queue, e.g. from network, audio or decoder threads
+    /// (allocates one node of the inbox, no mutex of the runner). the queue is created on the main thread at the start of next update(), and build_task_queue adds its steps there
+    /// @param build_task_queue called with the new queue (on the main thread)
+    void postTaskQueue(int task_id, taskrunner::symbol::Symbol name, CreateTaskQueueFunction<App> build_task_queue) {
+        posted_task_queues.push(CreateTaskQueueTask<App>(task_id, name, TaskQueueHandle(), std::move(build_task_queue)));
+    }
+
+    /// (interning the name locks the symbol table, intern it beforehand to avoid that)
+    void postTaskQueue(int task_id, const std::string& name, CreateTaskQueueFunction<App> build_task_queue) {
+        postTaskQueue(task_id, taskrunner::symbol::intern(name), std::move(build_task_queue));
+    }
+
+    void postTaskQueue(const std::string& name, CreateTaskQueueFunction<App> build_task_queue) {
+        postTaskQueue(0, name, std::move(build_task_queue));
+    }
+
+    /// post task queue with unique anonymous name
+    void postTaskQueue(CreateTaskQueueFunction<App> build_task_queue) {
+        posted_task_queues.push(CreateTaskQueueTask<App>(0, taskrunner::symbol::SymbolTable::shared().anonymous(), TaskQueueHandle(), std::move(build_task_queue)));
+    }
+
+    /// create task queues posted by postTaskQueue() (only an atomic load when nothing was posted)
+    void createPostedTaskQueues() {
+        if (posted_task_queues.empty()) {
+            return;
+        }
+        posted_task_queues.consume([this](CreateTaskQueueTask<App>&& t) {
+            auto&& new_task_queue = createTaskQueue(t.task_id, t.task_queue_name);
+            t.func_for_new_task_queue(new_task_queue);
+        });
+    }
+
+    /// @brief get task queue by handle
+    /// @return none if the task queue already finished (or cleared)
+    taskrunner::optional::optional_ref<TaskQueue<App>> getTaskQueue(TaskQueueHandle handle) {
+        TaskQueue<App>* task_queue = task_queues.get(handle);
+        if (task_queue == nullptr || task_queue->finished) {
+            return taskrunner::optional::none;
+        }
+        return std::ref(*task_queue);
+    }
+
+    bool isAlive(TaskQueueHandle handle) const {
+        const TaskQueue<App>* task_queue = task_queues.get(handle);
+        return task_queue != nullptr && !task_queue->finished;
+    }
+
+    /// true if the task queue was cancelled and is not reclaimed yet
+    bool isCancelled(TaskQueueHandle handle) const {
+        const TaskQueue<App>* task_queue = task_queues.get(handle);
+        return task_queue != nullptr && task_queue->cancelled && !task_queue->finished;
+    }
+
+    /// @brief cancel the task queue, and the task queues created by it (then_create_task_queue(), recursively).
+    /// remaining steps are not run (callbacks already collected for update() / draw() still run, and async work
+    /// in progress finishes), and the queues are reclaimed on next update(). O(1) + number of cancelled queues.
+    /// a finished queue still reaches its descendants until the last of them finished (and its pending
+    /// then_create_task_queue() steps don't create queues)
+    /// @return number of cancelled task queues (0 if it and its descendants already finished or were cancelled)
+    size_t cancel(TaskQueueHandle handle) {
+        return cancelTree(handle);
+    }
+
+    /// @brief run the graph: nodes without dependencies start on next update(), and each other node starts on
+    /// the update where its last dependency finished. dependents are released by in-degree counters
+    /// (O(released edges) per finished node, nothing is polled)
+    /// @return handle to cancel the run (cancelGraph()), invalid if graph is nullptr (build() failed)
+    TaskGraphRunHandle runGraph(TaskGraphRef<App> graph) {
+        if (!graph || graph->size() == 0) {
+            return TaskGraphRunHandle();
+        }
+        TaskGraphRunHandle run_handle = graph_runs.emplace(std::move(graph));
+        const TaskGraph<App>& run_graph = *graph_runs.get(run_handle)->graph;
+        for (typename TaskGraph<App>::NodeId node = 0; node < run_graph.size(); node++) {
+            if (run_graph.getInDegrees()[node] == 0) {
+                startGraphNode(run_handle, node, false);
+            }
+        }
+        return run_handle;
+    }
+
+    /// @brief cancel running nodes of the graph (and the task queues created by them). the other nodes don't start
+    /// @return number of cancelled task queues
+    size_t cancelGraph(TaskGraphRunHandle run_handle) {
+        GraphRun* run = graph_runs.get(run_handle);
+        if (run == nullptr || run->cancelled) {
+            return 0;
+        }
+        run->cancelled = true;
+        size_t cancelled_count = 0;
+        for (TaskQueueHandle handle : run->node_queues) {
+            cancelled_count += task_queues.contains(handle) ? cancelTree(handle) : 0;
+        }
+        return cancelled_count;
+    }
+
+    /// true until all nodes of the run finished (or the running ones were cancelled)
+    bool isGraphRunning(TaskGraphRunHandle run_handle) const {
+        return graph_runs.contains(run_handle);
+    }
+
+    /// @brief resume task queues waiting for the channel (TaskQueue::wait_for_event()) on next update().
+    /// call on the main thread (e.g. from an update callback, or before update())
+    /// @return number of resumed task queues
+    size_t notify(taskrunner::symbol::Symbol channel) {
+        auto it = event_waiters.find(channel.id());
+        if (it == event_waiters.end()) {
+            return 0;
+        }
+
+        size_t resumed_count = 0;
+        for (TaskQueueHandle handle : it->second.handles) {
+            TaskQueue<App>* task_queue = task_queues.get(handle);
+            if (task_queue != nullptr && !task_queue->finished && !task_queue->event_notified) {
+                task_queue->event_notified = true;
+                ready_task_queues.push_back(handle);
+                resumed_count++;
+            }
+        }
+        // (storage is kept for next waiters)
+        it->second.handles.clear();
+        return resumed_count;
+    }
+
+    size_t notify(const std::string& channel) {
+        return notify(taskrunner::symbol::intern(channel));
+    }
+
+    /// @brief cancel() all task queues with the name
+    size_t cancelByName(taskrunner::symbol::Symbol name) {
+        auto it = task_queues_by_name.find(name.id());
+        return it != task_queues_by_name.end() ? cancelList(it->second, &TaskQueueLinks::by_name) : 0;
+    }
+
+    size_t cancelByName(const std::string& name) {
+        return cancelByName(taskrunner::symbol::intern(name));
+    }
+
+    /// @brief cancel() all task queues with the task id
+    size_t cancelByTaskId(int task_id) {
+        auto it = task_queues_by_task_id.find(task_id);
+        return it != task_queues_by_task_id.end() ? cancelList(it->second, &TaskQueueLinks::by_task_id) : 0;
+    }
+
+    /// number of alive task queues
+    size_t getTaskQueueCount() const {
+        return task_queues.size() - finished_task_queue_count;
+    }
+
+    /// number of task queues which will be processed on next update (excluding waiting ones)
+    size_t getReadyTaskQueueCount() const {
+        return ready_task_queues.size();
+    }
+
+    /// number of task queues sleeping until their wait deadline
+    size_t getWaitingTaskQueueCount() const {
+        return wait_deadlines.size();
+    }
+
+    /// number of running tween steps
+    size_t getTweenCount() const {
+        return tweens.size();
+    }
+
+    /// @brief advance due task queues on worker threads when there are many (0: serial, default).
+    /// only advancing runs in parallel (checking waits, popping steps, collecting callbacks): callbacks still run
+    /// on the main thread in the same order as the serial path, and steps which touch shared state or call
+    /// user code (sync waits, events, wait_until, tweens, async, creating queues) are continued on the main thread
+    /// @param thread_count worker threads (the main thread works too)
+    /// @param min_task_queues parallel only on updates where at least this many task queues are due
+    void setParallelThreadCount(size_t thread_count, size_t min_task_queues = 4096) {
+        if (thread_count != parallel_thread_count) {
+            parallel_pool.reset();
+        }
+        parallel_thread_count = thread_count;
+        parallel_min_task_queues = std::max<size_t>(min_task_queues, 1);
+    }
+
+    size_t getParallelThreadCount() const {
+        return parallel_thread_count;
+    }
+
+    /// @brief limit update tasks (and task queue creations) per update(). remaining tasks are deferred
+    /// to the next frames in order. at least one task runs per frame, and TaskPriority::CRITICAL tasks always run
+    /// (they are not counted by max_tasks, but their time counts towards max_microseconds).
+    /// a queue parks on its update task until it ran, so its following steps keep their order
+    /// (a queue whose task ran continues on the same update, its next update task is appended)
+    /// @param max_microseconds time budget (0: unlimited)
+    /// @param max_tasks task count budget (0: unlimited)
+    void setUpdateBudget(uint64_t max_microseconds, size_t max_tasks = 0) {
+        update_budget = static_cast<taskrunner::clock::nanoseconds>(max_microseconds) * 1000;
+        update_budget_tasks = max_tasks;
+    }
+
+    bool hasUpdateBudget() const {
+        return update_budget > 0 || update_budget_tasks > 0;
+    }
+
+    /// number of tasks deferred to the next frame by the last update()
+    size_t getDeferredTaskCount() const {
+        return deferred_task_count;
+    }
+
+    /// sum of getDeferredTaskCount() of all frames (a task deferred for 3 frames counts 3)
+    uint64_t getTotalDeferredTaskCount() const {
+        return total_deferred_task_count;
+    }
+
+    /// @brief current state, high-water marks and histograms of the scheduler (for monitoring overlays)
+    taskrunner::stats::Stats getStats() const {
+        taskrunner::stats::Stats stats;
+        stats.task_queue_count = getTaskQueueCount();
+        stats.ready_task_queue_count = ready_task_queues.size();
+        stats.waiting_task_queue_count = wait_deadlines.size();
+        stats.pending_task_count = pending_task_count;
+        stats.pending_callback_count = update_tasks.size() + critical_update_tasks.size() + draw_tasks.size() + create_task_queue_tasks.size();
+        stats.task_storage_bytes = task_storage_bytes;
+        stats.scheduler_bytes = task_queues.capacity() * sizeof(TaskQueue<App>)
+            + (ready_task_queues.capacity() + processing_task_queues.capacity()) * sizeof(TaskQueueHandle)
+            + wait_deadlines.capacityBytes()
+            + (update_tasks.capacity() + critical_update_tasks.capacity() + draw_tasks.capacity()) * sizeof(PendingTask<App>)
+            + create_task_queue_tasks.capacity() * sizeof(CreateTaskQueueTask<App>)
+            + tweens.capacityBytes();
+        for (const ChunkBuffer& buffer : chunk_buffers) {
+            stats.scheduler_bytes += (buffer.update_tasks.capacity() + buffer.critical_update_tasks.capacity() + buffer.draw_tasks.capacity()) * sizeof(PendingTask<App>)
+                + buffer.ready_task_queues.capacity() * sizeof(TaskQueueHandle)
+                + buffer.wait_deadlines.capacity() * sizeof(std::pair<taskrunner::clock::nanoseconds, TaskQueueHandle>);
+        }
+        stats.scheduler_bytes += advance_entries.capacity() * sizeof(AdvanceEntry);
+        stats.index_entry_count = task_queues_by_name.size() + task_queues_by_task_id.size();
+        stats.scheduler_bytes += task_queues_by_name.size() * sizeof(std::pair<const uint32_t, TaskQueueHandle>)
+            + task_queues_by_task_id.size() * sizeof(std::pair<const int, TaskQueueHandle>);
+        stats.sync_group_count = sync_groups->getGroupCount();
+        stats.tween_count = tweens.size();
+        for (const auto& waiters : event_waiters) {
+            stats.event_waiter_count += waiters.second.handles.size();
+            stats.scheduler_bytes += waiters.second.handles.capacity() * sizeof(TaskQueueHandle);
+        }
+        stats.max_task_queue_count = max_task_queue_count;
+        stats.max_pending_task_count = max_pending_task_count;
+        stats.max_task_storage_bytes = max_task_storage_bytes;
+        stats.process_time = process_time;
+        stats.wait_lateness = wait_lateness;
+        return stats;
+    }
+
+    /// reset histograms, and high-water marks to current values
+    void resetStats() {
+        max_task_queue_count = task_queues.size();
+        max_pending_task_count = pending_task_count;
+        max_task_storage_bytes = task_storage_bytes;
+        process_time.reset();
+        wait_lateness.reset();
+    }
+
+    /// @brief (called by TaskQueue) join the sync group of the task queue when its first sync wait is added,
+    /// so queues without sync waits don't hold the group. anonymous names are unique, so they don't join
+    void joinSyncGroup(TaskQueue<App>& task_queue) {
+        if (task_queue.sync_group >= 0 || task_queue.task_queue_name.isAnonymous()) {
+            return;
+        }
+        task_queue.sync_group = sync_groups->join(task_queue.task_id, task_queue.task_queue_name);
+    }
+
+    /// @brief (called by TaskQueue) steps added or removed, or their storage changed
+    void countTasks(int64_t task_count, int64_t storage_bytes) {
+        pending_task_count = static_cast<size_t>(static_cast<int64_t>(pending_task_count) + task_count);
+        task_storage_bytes = static_cast<size_t>(static_cast<int64_t>(task_storage_bytes) + storage_bytes);
+        max_pending_task_count = std::max(max_pending_task_count, pending_task_count);
+        max_task_storage_bytes = std::max(max_task_storage_bytes, task_storage_bytes);
+    }
+
+#ifdef OFX_TASKRUNNER_TRACE
+    /// @brief record begin/end time of each executed step (and processTaskQueues()) into a ring buffer
+    /// @param capacity number of kept events (only used on the first call)
+    void startTrace(size_t capacity = 65536) {
+        if (!trace_buffer) {
+            trace_buffer.reset(new taskrunner::trace::TraceBuffer(capacity));
+        }
+        tracing = true;
+    }
+
+    void stopTrace() {
+        tracing = false;
+    }
+
+    bool isTracing() const {
+        return tracing;
+    }
+
+    /// null before startTrace()
+    const taskrunner::trace::TraceBuffer* getTraceBuffer() const {
+        return trace_buffer.get();
     }
 
+    /// write recorded events as Chrome trace JSON (open with chrome://tracing or https://ui.perfetto.dev)
+    void writeTrace(std::ostream& out) const {
+        if (trace_buffer) {
+            trace_buffer->writeChromeJson(out);
+        } else {
+            taskrunner::trace::TraceBuffer(1).writeChromeJson(out);
+        }
+    }
+
+    bool saveTrace(const std::string& path) const {
+        std::ofstream file(path);
+        if (!file) {
+            taskrunner::adapter::LogError("ofxTaskRunner") << "failed to open " << path;
+            return false;
+        }
+        writeTrace(file);
+        return true;
+    }
+#endif
+
     void stop() {
         _should_end = true;
         clear();
@@ -558,10 +4959,146 @@ protected:
     /// This should be set on setup
     taskrunner::optional::optional_ref<App> app;
 
-    taskrunner::container::queue<std::function<void(App&)>> update_tasks;
-    taskrunner::container::queue<std::function<void(App&)>> draw_tasks;
+    /// tasks collected by processTaskQueues() (storage is reused among frames)
+    std::vector<PendingTask<App>> update_tasks;
+    std::vector<PendingTask<App>> critical_update_tasks;
+    std::vector<PendingTask<App>> draw_tasks;
     /// tasks which create new task queue
-    taskrunner::container::queue<CreateTaskQueueTask<App>> create_task_queue_tasks;
+    std::vector<CreateTaskQueueTask<App>> create_task_queue_tasks;
     bool _should_end = false;
-    vector<TaskQueue<App>> task_queues;
+    taskrunner::container::slot_map<TaskQueue<App>> task_queues;
+    /// finished task queues kept for their children (see TaskQueue::finished)
+    size_t finished_task_queue_count = 0;
+
+    /// task queues which have runnable tasks
+    std::vector<TaskQueueHandle> ready_task_queues;
+    std::vector<TaskQueueHandle> processing_task_queues;
+    /// min-heap of wait deadlines, so update() only touches task queues which are due
+    taskrunner::container::deadline_heap<TaskQueueHandle> wait_deadlines;
+    /// task queues reclaimed by cancel since the last compactWaitDeadlines() (upper bound of stale deadlines)
+    size_t cancelled_wait_count = 0;
+
+    taskrunner::sync::SyncBackend* sync_groups = &taskrunner::sync::SyncGroups::shared();
+    /// see setMemoryResource()
+    taskrunner::memory::memory_resource* memory_resource = taskrunner::memory::defaultResource();
+
+    bool drift_free = false;
+
+    /// see getStats()
+    size_t pending_task_count = 0;
+    size_t task_storage_bytes = 0;
+    size_t max_task_queue_count = 0;
+    size_t max_pending_task_count = 0;
+    size_t max_task_storage_bytes = 0;
+    taskrunner::stats::Histogram process_time;
+    taskrunner::stats::Histogram wait_lateness;
+
+    /// see setUpdateBudget()
+    taskrunner::clock::nanoseconds update_budget = 0;
+    size_t update_budget_tasks = 0;
+    size_t deferred_task_count = 0;
+    uint64_t total_deferred_task_count = 0;
+    /// clock time of the last processTaskQueues() (parked queues resumed in update() continue at it)
+    taskrunner::clock::nanoseconds process_now = 0;
+
+    /// also used to measure the update budget (regardless of setClock())
+    taskrunner::clock::SteadyClock steady_clock;
+    taskrunner::clock::Clock* clock = &steady_clock;
+
+    struct SyncWaiters {
+        uint64_t generation = 0;
+        std::vector<TaskQueueHandle> handles;
+    };
+
+    /// first task queue of each name (symbol id) / task_id (see TaskQueueLinks; entries are erased when empty)
+    std::unordered_map<uint32_t, TaskQueueHandle> task_queues_by_name;
+    std::unordered_map<int, TaskQueueHandle> task_queues_by_task_id;
+    std::vector<TaskQueueHandle> cancel_stack;
+
+    /// running TaskGraph: remaining dependencies, start time (latest end of dependencies) and task queue of each node
+    struct GraphRun {
+        TaskGraphRef<App> graph;
+        std::vector<uint32_t> remaining;
+        std::vector<taskrunner::clock::nanoseconds> start_times;
+        std::vector<TaskQueueHandle> node_queues;
+        size_t running_count = 0;
+        bool cancelled = false;
+
+        GraphRun(TaskGraphRef<App> graph) {
+            this->graph = std::move(graph);
+            this->remaining = this->graph->getInDegrees();
+            this->start_times.assign(this->graph->size(), std::numeric_limits<taskrunner::clock::nanoseconds>::min());
+            this->node_queues.resize(this->graph->size());
+        }
+    };
+    taskrunner::container::slot_map<GraphRun> graph_runs;
+
+    /// see setParallelThreadCount(). each chunk of the processing list is advanced into its own buffers
+    static constexpr size_t parallel_chunk_size = 256;
+    size_t parallel_thread_count = 0;
+    size_t parallel_min_task_queues = 4096;
+    std::unique_ptr<taskrunner::async::ParallelFor> parallel_pool;
+
+    struct ChunkBuffer {
+        std::vector<PendingTask<App>> update_tasks;
+        std::vector<PendingTask<App>> critical_update_tasks;
+        std::vector<PendingTask<App>> draw_tasks;
+        std::vector<TaskQueueHandle> ready_task_queues;
+        std::vector<std::pair<taskrunner::clock::nanoseconds, TaskQueueHandle>> wait_deadlines;
+        taskrunner::stats::Histogram wait_lateness;
+
+        /// (keeps capacity for next update)
+        void clear() {
+            update_tasks.clear();
+            critical_update_tasks.clear();
+            draw_tasks.clear();
+            ready_task_queues.clear();
+            wait_deadlines.clear();
+            wait_lateness.reset();
+        }
+    };
+    std::vector<ChunkBuffer> chunk_buffers;
+
+    /// entry of the processing list in parallel advancement: what its queue added to the chunk buffers
+    struct AdvanceEntry {
+        TaskQueue<App>* task_queue = nullptr;
+        bool on_worker = false;
+        /// stopped at a step which needs the main thread
+        bool deferred = false;
+        uint32_t update_count = 0;
+        uint32_t critical_update_count = 0;
+        uint32_t draw_count = 0;
+        uint32_t ready_count = 0;
+        uint32_t deadline_count = 0;
+        uint32_t popped_count = 0;
+    };
+    std::vector<AdvanceEntry> advance_entries;
+    uint32_t advance_stamp = 0;
+
+    /// task queues posted from other threads (see postTaskQueue())
+    taskrunner::container::mpsc_queue<CreateTaskQueueTask<App>> posted_task_queues;
+
+    /// task queues parked on wait_for_event() for each channel (symbol id). cancelled ones are skipped on notify(), and pruned as more queues wait
+    std::unordered_map<uint32_t, EventWaiters> event_waiters;
+
+    /// running tween steps (see TaskQueue::tween())
+    taskrunner::tween::TweenTable tweens;
+
+    /// task queues waiting for sync group release (indexed by sync group)
+    std::vector<SyncWaiters> sync_waiters;
+    std::vector<int> waiting_sync_groups;
+
+    /// task queues whose async task finished (pushed from worker threads)
+    std::vector<TaskQueueHandle> completed_async_tasks;
+    std::atomic<bool> has_completed_async_tasks { false };
+    std::mutex async_mutex;
+    size_t async_thread_count = taskrunner::async::ThreadPool::getDefaultThreadCount();
+#ifdef OFX_TASKRUNNER_TRACE
+    /// see startTrace() (kept until destruction, worker threads may be recording)
+    std::unique_ptr<taskrunner::trace::TraceBuffer> trace_buffer;
+    std::atomic<bool> tracing { false };
+#endif
+
+    /// created on first async task (declared last: workers are joined before other members are destroyed)
+    std::unique_ptr<taskrunner::async::ThreadPool> thread_pool;
 };
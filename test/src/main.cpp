@@ -0,0 +1,1234 @@
+// Behaviour tests of ofxTaskRunner (headless, see ../CMakeLists.txt)
+//
+// Each test drives a runner with a VirtualClock, so waits expire on known
+// frames, and checks which callbacks ran (and in which order).
+// Pass a test name to run only that test.
+
+#include "ofxTaskRunner.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int failure_count = 0;
+
+static void check(bool ok, const char* expression, const char* file, int line) {
+	if (!ok) {
+		std::printf("  FAILED %s:%d: %s\n", file, line, expression);
+		failure_count++;
+	}
+}
+
+#define CHECK(expression) check((expression), #expression, __FILE__, __LINE__)
+
+struct TestApp {
+	std::vector<std::string> log;
+	int checks = 0;
+	bool ready = false;
+};
+
+using Runner = ofxTaskRunner<TestApp>;
+
+/// runner with its own clock and sync groups (tests don't share state)
+struct Fixture {
+	TestApp app;
+	taskrunner::clock::VirtualClock clock;
+	taskrunner::sync::SyncGroups sync_groups;
+	Runner runner;
+
+	Fixture() {
+		runner.setClock(clock);
+		runner.setSyncGroups(sync_groups);
+		runner.setup(app);
+	}
+
+	/// advance the clock, then update() and draw()
+	void frame(double millis) {
+		clock.advanceMillis(millis);
+		runner.update();
+		runner.draw();
+	}
+
+	std::string joined() const {
+		std::string s;
+		for (const auto& entry : app.log) {
+			s += s.empty() ? entry : " " + entry;
+		}
+		return s;
+	}
+};
+
+static TaskFunction<TestApp> logs(const std::string& entry) {
+	return [entry](TestApp& app) {
+		app.log.push_back(entry);
+	};
+}
+
+static ProgramFunction<TestApp> logsStep(const std::string& entry) {
+	return [entry](TestApp& app, int) {
+		app.log.push_back(entry);
+	};
+}
+
+//--------------------------------------------------------------
+static void testWaitThen() {
+	Fixture f;
+	TaskQueueHandle handle = f.runner.createTaskQueue().wait_ms(100).then(logs("a")).handle();
+	f.frame(50);
+	CHECK(f.app.log.empty());
+	f.frame(60);
+	CHECK(f.joined() == "a");
+	f.frame(16);
+	CHECK(!f.runner.isAlive(handle));
+}
+
+static void testHandleExpiresAfterSlotReuse() {
+	Fixture f;
+	TaskQueueHandle finished = f.runner.createTaskQueue().then(logs("a")).handle();
+	f.frame(16);
+	CHECK(!f.runner.isAlive(finished));
+	CHECK(!f.runner.getTaskQueue(finished).has_value());
+
+	// the slot is reused with a new generation: the old handle doesn't see the new queue
+	TaskQueueHandle reused = f.runner.createTaskQueue().wait_ms(100).then(logs("b")).handle();
+	CHECK(reused.index == finished.index);
+	CHECK(reused != finished);
+	CHECK(!f.runner.isAlive(finished));
+	CHECK(!f.runner.getTaskQueue(finished).has_value());
+	CHECK(f.runner.cancel(finished) == 0);
+	CHECK(f.runner.isAlive(reused));
+	CHECK(f.runner.getTaskQueue(reused).has_value());
+	f.frame(100);
+	CHECK(f.joined() == "a b");
+	CHECK(!f.runner.isAlive(reused));
+}
+
+static void testVirtualClock() {
+	// virtual time only moves when advanced, regardless of real time
+	Fixture f;
+	f.runner.createTaskQueue().wait_ms(10).then(logs("a"));
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	f.frame(0);
+	CHECK(f.app.log.empty());
+	f.clock.set(taskrunner::clock::fromMillis(10));
+	f.frame(0);
+	CHECK(f.joined() == "a");
+	CHECK(f.clock.now() == 10000000);
+	f.clock.advanceSec(1.5);
+	CHECK(f.clock.now() == 1510000000);
+	CHECK(taskrunner::clock::toSec(f.clock.now()) == 1.51);
+}
+
+static void testSteadyClock() {
+	// steady clock counts real time from its construction
+	taskrunner::clock::SteadyClock clock;
+	auto started = clock.now();
+	CHECK(started >= 0 && started < taskrunner::clock::fromSec(1));
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	CHECK(clock.now() - started >= taskrunner::clock::fromMillis(5));
+
+	TestApp app;
+	Runner runner;
+	runner.setClock(clock);
+	runner.setup(app);
+	runner.createTaskQueue().wait_ms(5).then(logs("a"));
+	runner.update();
+	CHECK(app.log.empty());
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	runner.update();
+	CHECK(app.log == std::vector<std::string> { "a" });
+}
+
+static void testStepOrder() {
+	Fixture f;
+	f.runner.createTaskQueue().then(logs("a")).then_on_draw(logs("draw")).wait_ms(10).then(logs("b"));
+	f.runner.createTaskQueue().then(logs("c"));
+	f.frame(0);
+	CHECK(f.joined() == "a c draw");
+	f.frame(10);
+	CHECK(f.joined() == "a c draw b");
+}
+
+static void testDriftFree() {
+	Fixture f;
+	f.runner.createTaskQueue().drift_free().wait_ms(100).then(logs("a")).wait_ms(100).then(logs("b")).wait_ms(100).then(logs("c"));
+	f.runner.createTaskQueue().wait_ms(100).then(logs("x")).wait_ms(100).then(logs("y")).wait_ms(100).then(logs("z"));
+	// a frame drop: the drift-free queue catches up on overdue waits within this update
+	f.frame(250);
+	CHECK(f.joined() == "a b x");
+	// and keeps its deadlines on the clock (c at 300), the other one continues from the late frame (y at 350)
+	f.frame(60);
+	CHECK(f.joined() == "a b x c");
+	f.frame(40);
+	CHECK(f.joined() == "a b x c y");
+}
+
+static void testDriftFreeDefault() {
+	Fixture f;
+	f.runner.setDriftFree(true);
+	auto& queue = f.runner.createTaskQueue();
+	CHECK(queue.isDriftFree());
+	queue.wait_ms(10).then(logs("a")).wait_ms(10).then(logs("b"));
+	f.frame(25);
+	CHECK(f.joined() == "a b");
+}
+
+static void testThenAsync() {
+	Fixture f;
+	f.runner.setAsyncThreadCount(1);
+	std::atomic<bool> release { false };
+	std::thread::id main_thread = std::this_thread::get_id();
+	std::thread::id async_thread;
+	std::thread::id done_thread;
+	f.runner.createTaskQueue().then_async([&] {
+		async_thread = std::this_thread::get_id();
+		while (!release.load()) {
+			std::this_thread::yield();
+		}
+		return 42;
+	}, [&](TestApp& app, int& result) {
+		done_thread = std::this_thread::get_id();
+		app.log.push_back("result " + std::to_string(result));
+	}).then(logs("after"));
+	f.runner.createTaskQueue().wait_ms(10).then(logs("other"));
+
+	// update() is not blocked while the worker runs
+	f.frame(16);
+	f.frame(16);
+	CHECK(f.joined() == "other");
+	release = true;
+	for (int i = 0; i < 1000 && f.app.log.size() < 3; i++) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		f.frame(16);
+	}
+	CHECK(f.joined() == "other result 42 after");
+	CHECK(async_thread != main_thread);
+	CHECK(done_thread == main_thread);
+}
+
+static void testThenAsyncException() {
+	Fixture f;
+	f.runner.createTaskQueue().then_async([]() -> int {
+		throw std::runtime_error("failed");
+	}, [](TestApp& app, int&) {
+		app.log.push_back("never");
+	}).then(logs("after"));
+	for (int i = 0; i < 1000 && f.app.log.empty(); i++) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		f.frame(16);
+	}
+	// (logged, and the queue continues)
+	CHECK(f.joined() == "after");
+}
+
+static void testCancel() {
+	Fixture f;
+	auto token = f.runner.createTaskQueue().wait_ms(100).then(logs("never")).getCancelToken();
+	f.frame(50);
+	CHECK(token.cancel() == 1);
+	CHECK(token.cancel() == 0);
+	f.frame(100);
+	CHECK(f.app.log.empty());
+	CHECK(!token.isActive());
+}
+
+static void testCancelChildren() {
+	Fixture f;
+	auto& parent = f.runner.createTaskQueue();
+	parent.then_create_task_queue("child", [](TaskQueue<TestApp>& child) {
+		child.wait_ms(100).then(logs("child"));
+	}).wait_ms(1000);
+	TaskQueueHandle handle = parent.handle();
+	f.frame(16);
+	CHECK(f.runner.cancel(handle) == 2);
+	f.frame(200);
+	CHECK(f.app.log.empty());
+	CHECK(f.runner.getTaskQueueCount() == 0);
+}
+
+static void testCancelChildrenOfFinishedQueue() {
+	Fixture f;
+	auto token = f.runner.createTaskQueue().then_create_task_queue("child", [](TaskQueue<TestApp>& child) {
+		child.then_create_task_queue("grandchild", [](TaskQueue<TestApp>& grandchild) {
+			grandchild.wait_ms(100).then(logs("grandchild"));
+		}).wait_ms(100).then(logs("child"));
+	}).getCancelToken();
+	f.frame(16);
+	f.frame(16);
+	CHECK(!token.isActive());
+	CHECK(f.runner.getTaskQueueCount() == 2);
+	CHECK(token.cancel() == 2);
+	f.frame(200);
+	CHECK(f.app.log.empty());
+	CHECK(f.runner.getTaskQueueCount() == 0);
+}
+
+static void testClearInChildCallback() {
+	Fixture f;
+	f.runner.createTaskQueue().then_create_task_queue("child", [&f](TaskQueue<TestApp>&) {
+		// destroys the parent; the queues created next reuse its slot
+		f.runner.clear();
+		f.runner.createTaskQueue().then(logs("a"));
+		f.runner.createTaskQueue().then(logs("b"));
+	});
+	f.frame(16);
+	f.frame(16);
+	CHECK(f.joined() == "a b");
+	CHECK(f.runner.getTaskQueueCount() == 0);
+	// (both slots are reclaimed: the parent's child count didn't land on the queue in its slot)
+	CHECK(f.runner.createTaskQueue().wait_ms(10).handle().index < 2);
+	CHECK(f.runner.createTaskQueue().wait_ms(10).handle().index < 2);
+}
+
+static void testCancelByNameAndTaskId() {
+	Fixture f;
+	f.runner.createTaskQueue(1, "intro").wait_ms(10).then(logs("intro"));
+	f.runner.createTaskQueue(2, "intro").wait_ms(10).then(logs("intro"));
+	f.runner.createTaskQueue(2, "main").wait_ms(10).then(logs("main"));
+	f.runner.createTaskQueue(3, "main").wait_ms(10).then(logs("kept"));
+	CHECK(f.runner.cancelByName("intro") == 2);
+	CHECK(f.runner.cancelByTaskId(2) == 1);
+	f.frame(20);
+	CHECK(f.joined() == "kept");
+}
+
+static void testAnonymousNames() {
+	Fixture f;
+	size_t symbol_count = taskrunner::symbol::SymbolTable::shared().size();
+	auto& queue = f.runner.createTaskQueue().wait_ms(10);
+	CHECK(queue.getName().rfind("task_queue_", 0) == 0);
+	CHECK(queue.getName() == queue.getName());
+	// (not interned, nor cached)
+	CHECK(taskrunner::symbol::SymbolTable::shared().size() == symbol_count);
+	CHECK(f.runner.createTaskQueue(0, "named").getName() == "named");
+}
+
+static void testIndexesShrink() {
+	Fixture f;
+	for (int i = 0; i < 100; i++) {
+		f.runner.createTaskQueue(i, "spawned" + std::to_string(i)).wait_ms(i % 3).then(logs("done"));
+		f.frame(1);
+	}
+	f.runner.createTaskQueue(1000, "kept").wait_ms(1000);
+	for (int i = 0; i < 5; i++) {
+		f.frame(16);
+	}
+	CHECK(f.app.log.size() == 100);
+	CHECK(f.runner.getStats().index_entry_count == 2);
+	CHECK(f.runner.cancelByName("kept") == 1);
+	f.frame(16);
+	CHECK(f.runner.getStats().index_entry_count == 0);
+	CHECK(f.runner.cancelByName("spawned0") == 0);
+}
+
+static void testCancelledDeadlinesAreCompacted() {
+	Fixture f;
+	auto& kept = f.runner.createTaskQueue().wait_ms(3600 * 1000.0).then(logs("kept"));
+	TaskQueueHandle kept_handle = kept.handle();
+	// queues cancelled in the middle of an hour-long wait, on every frame
+	for (int frame = 0; frame < 100; frame++) {
+		std::vector<TaskQueueHandle> handles;
+		for (int i = 0; i < 100; i++) {
+			handles.push_back(f.runner.createTaskQueue().wait_ms(3600 * 1000.0).then(logs("cancelled")).handle());
+		}
+		f.frame(16);
+		for (TaskQueueHandle handle : handles) {
+			f.runner.cancel(handle);
+		}
+		f.frame(16);
+		CHECK(f.runner.getStats().waiting_task_queue_count <= 201);
+	}
+	CHECK(f.runner.isAlive(kept_handle));
+	CHECK(f.runner.getTaskQueueCount() == 1);
+	f.frame(3600 * 1000.0);
+	CHECK(f.joined() == "kept");
+	CHECK(f.runner.getStats().waiting_task_queue_count == 0);
+}
+
+static void testWaitForEvent() {
+	Fixture f;
+	f.runner.createTaskQueue().wait_for_event("go").then(logs("go"));
+	// notified before reaching the step: not remembered
+	f.runner.createTaskQueue().wait_ms(100).wait_for_event("early").then(logs("never"));
+	CHECK(f.runner.notify("early") == 0);
+	f.frame(16);
+	CHECK(f.app.log.empty());
+	CHECK(f.runner.notify("go") == 1);
+	f.frame(16);
+	CHECK(f.joined() == "go");
+	f.frame(200);
+	CHECK(f.joined() == "go");
+	CHECK(f.runner.notify("go") == 0);
+}
+
+static void testCancelledEventWaitersArePruned() {
+	Fixture f;
+	f.runner.createTaskQueue().wait_for_event("go").then(logs("go"));
+	for (int i = 0; i < 1000; i++) {
+		auto token = f.runner.createTaskQueue().wait_for_event("go").then(logs("never")).getCancelToken();
+		f.frame(16);
+		token.cancel();
+	}
+	f.frame(16);
+	CHECK(f.runner.getStats().event_waiter_count < 64);
+	CHECK(f.runner.notify("go") == 1);
+	f.frame(16);
+	CHECK(f.joined() == "go");
+}
+
+static void testWaitUntil() {
+	Fixture f;
+	f.runner.createTaskQueue().wait_until([](TestApp& app) {
+		app.checks++;
+		return app.ready;
+	}, 0.1).then(logs("ready"));
+	// checked when reached, then once per 100 ms (not every frame)
+	for (int i = 0; i < 12; i++) {
+		f.frame(16);
+	}
+	CHECK(f.app.checks >= 2 && f.app.checks <= 3);
+	f.app.ready = true;
+	for (int i = 0; i < 7; i++) {
+		f.frame(16);
+	}
+	CHECK(f.joined() == "ready");
+}
+
+static void testPostTaskQueue() {
+	Fixture f;
+	const int thread_count = 4;
+	const int posts_per_thread = 500;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < thread_count; t++) {
+		threads.emplace_back([&f, t] {
+			for (int i = 0; i < posts_per_thread; i++) {
+				f.runner.postTaskQueue(t, "posted", [t, i](TaskQueue<TestApp>& queue) {
+					queue.then([t, i](TestApp& app) {
+						app.log.push_back(std::to_string(t) + ":" + std::to_string(i));
+					});
+				});
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	// created on the main thread at the start of next update(), and processed on it
+	CHECK(f.runner.getTaskQueueCount() == 0);
+	f.frame(0);
+	CHECK(f.app.log.size() == thread_count * posts_per_thread);
+	CHECK(f.runner.getTaskQueueCount() == 0);
+	// each thread's posts keep their order
+	std::vector<int> next(thread_count, 0);
+	for (const auto& entry : f.app.log) {
+		int t = std::stoi(entry.substr(0, entry.find(':')));
+		int i = std::stoi(entry.substr(entry.find(':') + 1));
+		CHECK(i == next[t]);
+		next[t] = i + 1;
+	}
+}
+
+static void testPostTaskQueueWhileUpdating() {
+	Fixture f;
+	std::atomic<bool> stop { false };
+	std::atomic<int> posted { 0 };
+	std::thread producer([&] {
+		while (!stop.load()) {
+			f.runner.postTaskQueue([](TaskQueue<TestApp>& queue) {
+				queue.then([](TestApp& app) { app.checks++; });
+			});
+			posted++;
+			std::this_thread::yield();
+		}
+	});
+	for (int i = 0; i < 200; i++) {
+		f.frame(1);
+	}
+	stop = true;
+	producer.join();
+	f.frame(1);
+	f.frame(1);
+	CHECK(f.app.checks == posted.load());
+}
+
+static void testSyncRelease() {
+	Fixture f;
+	f.runner.registerTaskId(1);
+	f.runner.registerTaskId(2);
+	f.runner.createTaskQueue(1, "group").wait_sync_ms(100).then(logs("1"));
+	f.runner.createTaskQueue(2, "group").wait_sync_ms(300).then(logs("2"));
+	f.frame(150);
+	// member 1 waits for member 2
+	CHECK(f.app.log.empty());
+	f.frame(160);
+	// (the last arrival releases the group, then the waiting member resumes on the same update)
+	CHECK(f.joined() == "2 1");
+}
+
+static void testSyncCancelledMemberLeaves() {
+	Fixture f;
+	f.runner.registerTaskId(1);
+	f.runner.registerTaskId(2);
+	f.runner.createTaskQueue(1, "group").wait_sync_ms(100).then(logs("1"));
+	auto token = f.runner.createTaskQueue(2, "group").wait_sync_ms(1000).then(logs("never")).getCancelToken();
+	f.frame(150);
+	CHECK(f.app.log.empty());
+	token.cancel();
+	f.frame(16);
+	CHECK(f.joined() == "1");
+}
+
+static void testSyncIgnoresQueuesWithoutSyncWait() {
+	Fixture f;
+	f.runner.registerTaskId(1);
+	f.runner.registerTaskId(2);
+	f.runner.createTaskQueue(1, "group").wait_sec(100).then(logs("plain"));
+	f.runner.createTaskQueue(1, "group").wait_sync_ms(100).then(logs("1"));
+	f.runner.createTaskQueue(2, "group").wait_sync_ms(100).then(logs("2"));
+	f.frame(150);
+	CHECK(f.joined() == "2 1");
+}
+
+static void testSyncThreadSafe() {
+	// two runners updated on their own threads, joining new groups while the other one checks releases
+	taskrunner::sync::SyncGroups sync_groups;
+	sync_groups.setThreadSafe(true);
+	sync_groups.registerTaskId(1);
+	sync_groups.registerTaskId(2);
+	const int group_count = 200;
+	auto run = [&](int task_id, TestApp& app) {
+		taskrunner::clock::VirtualClock clock;
+		Runner runner;
+		runner.setClock(clock);
+		runner.setSyncGroups(sync_groups);
+		runner.setup(app);
+		for (int i = 0; i < group_count; i++) {
+			runner.createTaskQueue(task_id, "thread_group" + std::to_string(i)).wait_ms(i % 7).wait_sync_ms(1).then(logs("done"));
+		}
+		for (int frame = 0; frame < 100000 && app.log.size() < group_count; frame++) {
+			clock.advanceMillis(1);
+			runner.update();
+			std::this_thread::yield();
+		}
+	};
+	TestApp app_a;
+	TestApp app_b;
+	std::thread thread_a([&] { run(1, app_a); });
+	std::thread thread_b([&] { run(2, app_b); });
+	thread_a.join();
+	thread_b.join();
+	CHECK(app_a.log.size() == group_count);
+	CHECK(app_b.log.size() == group_count);
+	CHECK(sync_groups.getGroupCount() == group_count);
+}
+
+static void testJoinAll() {
+	Fixture f;
+	f.runner.createTaskQueue().then_all(
+		[](TaskQueue<TestApp>& child) { child.wait_ms(100).then(logs("fast")); },
+		[](TaskQueue<TestApp>& child) { child.wait_ms(300).then(logs("slow")); })
+		.then(logs("done"));
+	// children start on the update which reached the join
+	f.frame(0);
+	f.frame(150);
+	CHECK(f.joined() == "fast");
+	f.frame(200);
+	CHECK(f.joined() == "fast slow done");
+}
+
+static void testJoinAny() {
+	Fixture f;
+	f.runner.createTaskQueue().then_any(
+		[](TaskQueue<TestApp>& child) { child.wait_ms(100).then(logs("fast")); },
+		[](TaskQueue<TestApp>& child) { child.wait_ms(300).then(logs("slow")); })
+		.then(logs("done"));
+	f.frame(150);
+	f.frame(300);
+	CHECK(f.joined() == "fast done");
+	CHECK(f.runner.getTaskQueueCount() == 0);
+}
+
+static void testProgram() {
+	Fixture f;
+	auto program = TaskProgram<TestApp>()
+		.wait_ms(100)
+		.then([](TestApp& app, int param) { app.log.push_back("on " + std::to_string(param)); })
+		.then_on_draw([](TestApp& app, int param) { app.log.push_back("draw " + std::to_string(param)); })
+		.wait_ms(50)
+		.then([](TestApp& app, int param) { app.log.push_back("off " + std::to_string(param)); })
+		.build();
+	CHECK(program->size() == 5);
+	CHECK(program->getDuration() == taskrunner::clock::fromMillis(150));
+
+	// instances share the steps, and each one has its own cursor and param
+	for (int i = 0; i < 3; i++) {
+		f.runner.createTaskQueue().then_program(program, i);
+	}
+	CHECK(program.use_count() == 4);
+	f.frame(60);
+	// (the first wait started when instantiated)
+	f.runner.createTaskQueue().then_program(program, 3);
+	f.frame(40);
+	CHECK(f.joined() == "on 0 on 1 on 2 draw 0 draw 1 draw 2");
+	f.frame(50);
+	CHECK(f.joined() == "on 0 on 1 on 2 draw 0 draw 1 draw 2 off 0 off 1 off 2");
+	f.frame(10);
+	CHECK(f.joined() == "on 0 on 1 on 2 draw 0 draw 1 draw 2 off 0 off 1 off 2 on 3 draw 3");
+	f.frame(50);
+	CHECK(f.app.log.back() == "off 3");
+	CHECK(f.runner.getTaskQueueCount() == 0);
+	CHECK(program.use_count() == 1);
+}
+
+static void testProgramBetweenSteps() {
+	Fixture f;
+	auto program = TaskProgram<TestApp>().then(logsStep("p")).wait_ms(10).then(logsStep("q")).build();
+	f.runner.createTaskQueue().then(logs("before")).then_program(program).then(logs("after")).then_program(program);
+	f.frame(0);
+	CHECK(f.joined() == "before p");
+	f.frame(10);
+	CHECK(f.joined() == "before p q after p");
+	f.frame(10);
+	CHECK(f.joined() == "before p q after p q");
+	CHECK(f.runner.getTaskQueueCount() == 0);
+}
+
+static void testRepeat() {
+	Fixture f;
+	// (repeat(1) ends a block without repeating it)
+	f.runner.createTaskQueue().then(logs("intro")).repeat(1).then(logs("r")).wait_ms(10).repeat(3).then(logs("end"));
+	// the repeated block is one step
+	CHECK(f.runner.getStats().pending_task_count == 3);
+	for (int i = 0; i < 5; i++) {
+		f.frame(10);
+	}
+	CHECK(f.joined() == "intro r r r end");
+	CHECK(f.runner.getTaskQueueCount() == 0);
+}
+
+static void testLoop() {
+	Fixture f;
+	auto token = f.runner.createTaskQueue().wait_ms(10).then(logs("l")).loop().getCancelToken();
+	for (int i = 0; i < 5; i++) {
+		f.frame(10);
+	}
+	CHECK(f.joined() == "l l l l l");
+	CHECK(token.isActive());
+	token.cancel();
+	f.frame(10);
+	CHECK(f.app.log.size() == 5);
+	CHECK(f.runner.getTaskQueueCount() == 0);
+}
+
+static void testProgramRepeat() {
+	Fixture f;
+	auto program = TaskProgram<TestApp>().then(logsStep("a")).wait_ms(10).repeat(2).then(logsStep("b")).wait_ms(5).repeat(3).build();
+	CHECK(program->getDuration() == taskrunner::clock::fromMillis(35));
+	f.runner.createTaskQueue().then_program(program).then(logs("done"));
+	for (int i = 0; i < 10; i++) {
+		f.frame(5);
+	}
+	CHECK(f.joined() == "a a b b b done");
+	CHECK(TaskProgram<TestApp>().wait_ms(10).loop().build()->getDuration() == std::numeric_limits<taskrunner::clock::nanoseconds>::max());
+}
+
+static void testEveryMs() {
+	Fixture f;
+	f.runner.createTaskQueue().every_ms(100, logs("tick"), 3).then(logs("done"));
+	f.frame(90);
+	CHECK(f.app.log.empty());
+	// drift-free: the late frame doesn't push the next ticks back
+	f.frame(30);
+	CHECK(f.joined() == "tick");
+	f.frame(80);
+	CHECK(f.joined() == "tick tick");
+	f.frame(100);
+	CHECK(f.joined() == "tick tick tick done");
+
+	Fixture g;
+	auto token = g.runner.createTaskQueue().every_ms(10, logs("forever")).then(logs("never")).getCancelToken();
+	for (int i = 0; i < 10; i++) {
+		g.frame(10);
+	}
+	CHECK(g.app.log.size() == 10);
+	CHECK(g.app.log.back() == "forever");
+	token.cancel();
+}
+
+static void testRepeatZeroKeepsSteps() {
+	Fixture f;
+	f.runner.createTaskQueue().then(logs("a")).repeat(0).then(logs("b"));
+	f.runner.createTaskQueue().then_program(TaskProgram<TestApp>().then(logsStep("p")).repeat(0).then(logsStep("q")).build());
+	f.frame(16);
+	f.frame(16);
+	CHECK(f.joined() == "a b p q");
+}
+
+static void testNullProgram() {
+	Fixture f;
+	f.runner.createTaskQueue().then_program(nullptr).then(logs("a"));
+	TaskGraph<TestApp> graph;
+	auto empty = graph.node("empty", nullptr);
+	auto b = graph.node("B", TaskProgram<TestApp>().then(logsStep("B")).build());
+	graph.after(b, empty);
+	auto run = f.runner.runGraph(graph.build());
+	for (int i = 0; i < 5 && f.runner.isGraphRunning(run); i++) {
+		f.frame(16);
+	}
+	CHECK(f.joined() == "a B");
+}
+
+static void testGraph() {
+	Fixture f;
+	TaskGraph<TestApp> graph;
+	auto a = graph.node("A", TaskProgram<TestApp>().wait_ms(100).then(logsStep("A")).build());
+	auto b = graph.node("B", TaskProgram<TestApp>().wait_ms(300).then(logsStep("B")).build());
+	auto c = graph.node("C", TaskProgram<TestApp>().wait_ms(50).then(logsStep("C")).build());
+	auto d = graph.node("D", TaskProgram<TestApp>().then(logsStep("D")).build());
+	graph.after(b, a).after(c, a).after(d, { b, c });
+	auto graph_ref = graph.build();
+	CHECK(graph_ref != nullptr);
+	CHECK(graph_ref->getCriticalPathDuration() == taskrunner::clock::fromMillis(400));
+
+	auto run = f.runner.runGraph(graph_ref);
+	for (int i = 0; i < 40 && f.runner.isGraphRunning(run); i++) {
+		f.frame(16);
+	}
+	CHECK(f.joined() == "A C B D");
+	CHECK(!f.runner.isGraphRunning(run));
+
+	TaskGraph<TestApp> cycle;
+	auto x = cycle.node("x", TaskProgram<TestApp>().build());
+	auto y = cycle.node("y", TaskProgram<TestApp>().build());
+	cycle.after(x, y).after(y, x);
+	CHECK(cycle.build() == nullptr);
+}
+
+static void testUpdateBudget() {
+	Fixture f;
+	f.runner.setUpdateBudget(0, 2);
+	for (int i = 0; i < 5; i++) {
+		f.runner.createTaskQueue().then(logs(std::to_string(i)));
+	}
+	f.runner.createTaskQueue().then(logs("critical"), TaskPriority::CRITICAL);
+	f.frame(16);
+	// critical callbacks are never deferred, normal ones keep their order
+	CHECK(f.app.log.size() == 3);
+	CHECK(std::find(f.app.log.begin(), f.app.log.end(), "critical") != f.app.log.end());
+	for (int i = 0; i < 5; i++) {
+		f.frame(16);
+	}
+	CHECK(f.app.log.size() == 6);
+	std::vector<std::string> normal;
+	for (const auto& entry : f.app.log) {
+		if (entry != "critical") {
+			normal.push_back(entry);
+		}
+	}
+	CHECK((normal == std::vector<std::string> { "0", "1", "2", "3", "4" }));
+	CHECK(f.runner.getDeferredTaskCount() == 0);
+}
+
+static void testUpdateBudgetKeepsStepOrder() {
+	Fixture f;
+	f.runner.setUpdateBudget(0, 1);
+	f.runner.createTaskQueue().then(logs("u1"));
+	f.runner.createTaskQueue().then(logs("u2")).then_on_draw(logs("d2"));
+	f.frame(16);
+	// (the draw of a deferred queue waits for its update)
+	CHECK(f.joined() == "u1");
+	f.frame(16);
+	CHECK(f.joined() == "u1 u2 d2");
+}
+
+static void testUpdateBudgetDelaysFollowingWait() {
+	Fixture f;
+	f.runner.setUpdateBudget(0, 1);
+	f.runner.createTaskQueue().then(logs("u0"));
+	f.runner.createTaskQueue().then(logs("u1")).wait_ms(100).then(logs("w1"));
+	f.frame(16);
+	CHECK(f.joined() == "u0");
+	// u1 is deferred to t = 32, and the wait starts then
+	f.frame(16);
+	CHECK(f.joined() == "u0 u1");
+	for (int i = 0; i < 6; i++) {
+		f.frame(16);
+	}
+	CHECK(f.joined() == "u0 u1");
+	f.frame(16);
+	CHECK(f.joined() == "u0 u1 w1");
+}
+
+static void testUpdateBudgetRunsWholeQueueWithinBudget() {
+	Fixture f;
+	f.runner.setUpdateBudget(0, 3);
+	f.runner.createTaskQueue().then(logs("a")).then_on_draw(logs("draw")).then(logs("b"));
+	f.runner.createTaskQueue().then(logs("c"));
+	f.frame(16);
+	// (a resumed queue continues on the same update while the budget allows)
+	CHECK(f.joined() == "a c b draw");
+}
+
+static void testCriticalTasksDontUseTaskBudget() {
+	Fixture f;
+	f.runner.setUpdateBudget(0, 2);
+	for (int i = 0; i < 5; i++) {
+		f.runner.createTaskQueue().then(logs("critical"), TaskPriority::CRITICAL);
+	}
+	for (int i = 0; i < 3; i++) {
+		f.runner.createTaskQueue().then(logs(std::to_string(i)));
+	}
+	f.frame(16);
+	CHECK(f.app.log.size() == 7);
+	CHECK(f.runner.getDeferredTaskCount() == 1);
+	f.frame(16);
+	CHECK(f.app.log.size() == 8);
+	CHECK(f.app.log.back() == "2");
+}
+
+static void testStats() {
+	Fixture f;
+	for (int i = 0; i < 10; i++) {
+		f.runner.createTaskQueue().wait_ms(10).then(logs("a"));
+	}
+	auto stats = f.runner.getStats();
+	CHECK(stats.task_queue_count == 10);
+	CHECK(stats.pending_task_count == 20);
+	CHECK(stats.task_storage_bytes > 0);
+	f.frame(0);
+	CHECK(f.runner.getStats().waiting_task_queue_count == 10);
+	// 5 ms late
+	f.frame(15);
+	stats = f.runner.getStats();
+	CHECK(stats.task_queue_count == 0);
+	CHECK(stats.pending_task_count == 0);
+	CHECK(stats.max_task_queue_count == 10);
+	CHECK(stats.max_pending_task_count == 20);
+	CHECK(stats.process_time.getCount() == 2);
+	CHECK(stats.wait_lateness.getCount() == 10);
+	CHECK(stats.wait_lateness.getMin() == taskrunner::clock::fromMillis(5));
+	CHECK(stats.wait_lateness.getMax() == taskrunner::clock::fromMillis(5));
+	CHECK(stats.wait_lateness.getPercentile(99) == taskrunner::clock::fromMillis(5));
+
+	f.runner.resetStats();
+	stats = f.runner.getStats();
+	CHECK(stats.process_time.getCount() == 0);
+	CHECK(stats.wait_lateness.getCount() == 0);
+	CHECK(stats.max_task_queue_count == 0);
+}
+
+static void testHistogram() {
+	taskrunner::stats::Histogram histogram;
+	CHECK(histogram.getPercentile(50) == 0);
+	// bucket 0: 0, bucket i: [2^(i-1), 2^i)
+	for (taskrunner::clock::nanoseconds value : { 0, 1, 3, 3, 100, 1000 }) {
+		histogram.add(value);
+	}
+	histogram.add(-5);
+	CHECK(histogram.getCount() == 7);
+	CHECK(histogram.getBucket(0) == 2);
+	CHECK(histogram.getBucket(1) == 1);
+	CHECK(histogram.getBucket(2) == 2);
+	CHECK(histogram.getBucket(7) == 1);
+	CHECK(histogram.getBucket(10) == 1);
+	CHECK(histogram.getMin() == 0);
+	CHECK(histogram.getMax() == 1000);
+	CHECK(histogram.getMean() == 1107 / 7);
+	// percentiles are upper bounds of buckets, at most the max
+	CHECK(histogram.getPercentile(50) == 4);
+	CHECK(histogram.getPercentile(80) == 128);
+	CHECK(histogram.getPercentile(100) == 1000);
+
+	taskrunner::stats::Histogram other;
+	other.add(1 << 20);
+	histogram.merge(other);
+	CHECK(histogram.getCount() == 8);
+	CHECK(histogram.getMax() == 1 << 20);
+	CHECK(histogram.getBucket(21) == 1);
+}
+
+static void testTween() {
+	Fixture f;
+	float value = -1.0f;
+	f.runner.createTaskQueue().tween_ms(300, &value, 0.0f, 1.0f).then(logs("done"));
+	f.frame(0);
+	f.frame(150);
+	CHECK(value > 0.4f && value < 0.6f);
+	f.frame(150);
+	f.frame(16);
+	CHECK(value == 1.0f);
+	CHECK(f.joined() == "done");
+	CHECK(f.runner.getTweenCount() == 0);
+}
+
+static void testCancelStopsTween() {
+	Fixture f;
+	// the target may be destroyed right after cancel
+	std::unique_ptr<float> value(new float(-1.0f));
+	auto token = f.runner.createTaskQueue().tween_ms(300, value.get(), 0.0f, 1.0f).then(logs("never")).getCancelToken();
+	f.frame(0);
+	f.frame(100);
+	float cancelled_value = *value;
+	CHECK(cancelled_value > 0.0f && cancelled_value < 1.0f);
+	token.cancel();
+	CHECK(f.runner.getTweenCount() == 0);
+	f.frame(50);
+	CHECK(*value == cancelled_value);
+	value.reset();
+	f.frame(300);
+	CHECK(f.app.log.empty());
+}
+
+#ifdef OFX_TASKRUNNER_PMR
+// (std::pmr must only be used where the standard library provides it for the deployment target)
+#ifndef __cpp_lib_memory_resource
+#error "OFX_TASKRUNNER_PMR without __cpp_lib_memory_resource"
+#endif
+
+/// counts allocations, and forwards them to the default resource
+struct CountingResource : std::pmr::memory_resource {
+	size_t allocation_count = 0;
+
+	void* do_allocate(size_t bytes, size_t alignment) override {
+		allocation_count++;
+		return std::pmr::get_default_resource()->allocate(bytes, alignment);
+	}
+	void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+		std::pmr::get_default_resource()->deallocate(p, bytes, alignment);
+	}
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+		return this == &other;
+	}
+};
+
+static void testMemoryResource() {
+	CountingResource resource;
+	Fixture f;
+	f.runner.setMemoryResource(resource);
+	f.runner.createTaskQueue().wait_ms(10).then(logs("a"));
+	CHECK(resource.allocation_count > 0);
+	f.frame(20);
+	CHECK(f.joined() == "a");
+}
+#endif
+
+#ifdef OFX_TASKRUNNER_SHARED_MEMORY_SYNC
+static void testSharedMemorySync() {
+	// two runners on separate segment mappings stand in for two processes
+	const char* segment_name = "/ofxTaskRunner_test";
+	taskrunner::sync::SharedMemorySyncGroups::remove(segment_name);
+	{
+		TestApp app;
+		taskrunner::clock::VirtualClock clock;
+		taskrunner::sync::SharedMemorySyncGroups groups_a(segment_name);
+		taskrunner::sync::SharedMemorySyncGroups groups_b(segment_name);
+		CHECK(taskrunner::sync::SharedMemorySyncGroups::isSupported());
+		CHECK(groups_a.isOpen() && groups_b.isOpen());
+		Runner runner_a;
+		Runner runner_b;
+		runner_a.setClock(clock);
+		runner_b.setClock(clock);
+		runner_a.setSyncGroups(groups_a);
+		runner_b.setSyncGroups(groups_b);
+		runner_a.setup(app);
+		runner_b.setup(app);
+		runner_a.registerTaskId(1);
+		runner_a.registerTaskId(2);
+		runner_b.registerTaskId(1);
+		runner_b.registerTaskId(2);
+
+		runner_a.createTaskQueue(1, "group").wait_sync_ms(100).then(logs("a"));
+		runner_b.createTaskQueue(2, "group").wait_sync_ms(300).then(logs("b"));
+		auto frame = [&](double millis) {
+			clock.advanceMillis(millis);
+			runner_a.update();
+			runner_b.update();
+			// (a wakes up on its next update after b arrived)
+			runner_a.update();
+		};
+		frame(150);
+		CHECK(app.log.empty());
+		frame(160);
+		CHECK(app.log == (std::vector<std::string> { "b", "a" }));
+	}
+	taskrunner::sync::SharedMemorySyncGroups::remove(segment_name);
+}
+
+static void testSharedMemoryReleaseTime() {
+	const char* segment_name = "/ofxTaskRunner_test_release";
+	taskrunner::sync::SharedMemorySyncGroups::remove(segment_name);
+	{
+		taskrunner::sync::SharedMemorySyncGroups groups_a(segment_name);
+		taskrunner::sync::SharedMemorySyncGroups groups_b(segment_name);
+		groups_a.registerTaskId(1);
+		groups_b.registerTaskId(2);
+		auto name = taskrunner::symbol::intern("release_time");
+		int group_a = groups_a.join(1, name);
+		int group_b = groups_b.join(2, name);
+		CHECK(group_a >= 0 && group_a == group_b);
+		// each generation is released by its latest arrival (also earlier than that of the previous generation)
+		for (int generation = 0; generation < 5; generation++) {
+			auto time_a = taskrunner::clock::fromMillis(generation % 2 == 0 ? 100 * (5 - generation) : 3);
+			auto time_b = taskrunner::clock::fromMillis(50);
+			uint64_t target_a = groups_a.arrive(group_a, time_a);
+			CHECK(!groups_a.isReleased(group_a, target_a));
+			uint64_t target_b = groups_b.arrive(group_b, time_b);
+			CHECK(target_a == target_b);
+			CHECK(groups_a.isReleased(group_a, target_a));
+			CHECK(groups_a.getReleaseTime(group_a) == std::max(time_a, time_b));
+			CHECK(groups_b.getReleaseTime(group_b) == std::max(time_a, time_b));
+		}
+
+		// owner only
+		int fd = shm_open(segment_name, O_RDONLY, 0);
+		struct stat st;
+		CHECK(fd >= 0 && fstat(fd, &st) == 0 && (st.st_mode & 0777) == 0600);
+		if (fd >= 0) {
+			close(fd);
+		}
+	}
+	taskrunner::sync::SharedMemorySyncGroups::remove(segment_name);
+}
+
+static void testSharedMemoryMemberLimit() {
+	const char* segment_name = "/ofxTaskRunner_test_members";
+	taskrunner::sync::SharedMemorySyncGroups::remove(segment_name);
+	{
+		taskrunner::sync::SharedMemorySyncGroups groups(segment_name);
+		groups.registerTaskId(1);
+		auto name = taskrunner::symbol::intern("crowded");
+		int group = -1;
+		for (uint32_t i = 0; i < taskrunner::sync::SharedMemorySyncGroups::max_members; i++) {
+			group = groups.join(1, name);
+		}
+		CHECK(group >= 0);
+		// (the count would wrap around to 0, and the next arrival would release the barrier)
+		CHECK(groups.join(1, name) == -1);
+		uint64_t target = groups.arrive(group, taskrunner::clock::fromMillis(10));
+		CHECK(!groups.isReleased(group, target));
+
+		groups.leave(group, target);
+		CHECK(groups.join(1, name) == group);
+	}
+	taskrunner::sync::SharedMemorySyncGroups::remove(segment_name);
+}
+#endif
+
+#ifdef OFX_TASKRUNNER_TRACE
+static size_t countOf(const std::string& text, const std::string& pattern) {
+	size_t count = 0;
+	for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + pattern.size())) {
+		count++;
+	}
+	return count;
+}
+
+static void testTrace() {
+	Fixture f;
+	f.runner.startTrace();
+	CHECK(f.runner.isTracing());
+	f.runner.createTaskQueue(7, "traced").then(logs("a")).label("step \"a\"").then_on_draw(logs("d")).label("draw_d");
+	f.frame(16);
+	f.runner.stopTrace();
+	f.runner.createTaskQueue().then(logs("untraced"));
+	f.frame(16);
+
+	// process_task_queues, update and draw of the first frame
+	size_t update_count = 0;
+	size_t draw_count = 0;
+	size_t process_count = 0;
+	f.runner.getTraceBuffer()->for_each([&](const taskrunner::trace::Event& event) {
+		update_count += event.type == taskrunner::trace::EventType::UPDATE ? 1 : 0;
+		draw_count += event.type == taskrunner::trace::EventType::DRAW ? 1 : 0;
+		process_count += event.type == taskrunner::trace::EventType::PROCESS_TASK_QUEUES ? 1 : 0;
+		CHECK(event.begin <= event.end);
+	});
+	CHECK(update_count == 1 && draw_count == 1 && process_count == 1);
+	CHECK(f.runner.getTraceBuffer()->getRecordedCount() == 3);
+
+	std::ostringstream out;
+	f.runner.writeTrace(out);
+	std::string json = out.str();
+	CHECK(json.rfind("{\"traceEvents\":[\n{", 0) == 0);
+	const std::string json_end = "\n],\"displayTimeUnit\":\"ms\"}\n";
+	CHECK(json.size() > json_end.size() && json.compare(json.size() - json_end.size(), json_end.size(), json_end) == 0);
+	CHECK(countOf(json, "\"ph\":\"X\"") == 3);
+	CHECK(countOf(json, "},\n{") == 2);
+	CHECK(countOf(json, "\"name\":\"step \\\"a\\\"\",\"cat\":\"update\"") == 1);
+	CHECK(countOf(json, "\"name\":\"draw_d\",\"cat\":\"draw\"") == 1);
+	CHECK(countOf(json, "\"args\":{\"task_queue\":\"traced\",\"task_id\":7}") == 2);
+	CHECK(countOf(json, "\"name\":\"process_task_queues\"") == 1);
+}
+
+static void testTraceRingBuffer() {
+	taskrunner::trace::TraceBuffer buffer(5);
+	CHECK(buffer.getCapacity() == 8);
+	for (int i = 0; i < 20; i++) {
+		taskrunner::trace::Event event;
+		event.begin = i;
+		event.end = i + 1;
+		buffer.record(event);
+	}
+	CHECK(buffer.getRecordedCount() == 20);
+	// the latest events are kept, oldest first
+	std::vector<taskrunner::clock::nanoseconds> begins;
+	buffer.for_each([&](const taskrunner::trace::Event& event) {
+		begins.push_back(event.begin);
+	});
+	CHECK((begins == std::vector<taskrunner::clock::nanoseconds> { 12, 13, 14, 15, 16, 17, 18, 19 }));
+}
+#endif
+
+/// random mix of steps, logged with per-frame stats
+static std::vector<std::string> runMixedQueues(size_t thread_count, size_t num_queues, size_t budget_tasks = 0) {
+	Fixture f;
+	f.runner.setParallelThreadCount(thread_count, 1);
+	f.runner.setUpdateBudget(0, budget_tasks);
+	for (int task_id = 1; task_id <= 3; task_id++) {
+		f.runner.registerTaskId(task_id);
+	}
+	auto program = TaskProgram<TestApp>().wait_ms(20).then(logsStep("p")).then_on_draw(logsStep("pd")).repeat(3).build();
+	std::mt19937 random(42);
+	std::vector<CancelToken<TestApp>> tokens;
+	for (size_t i = 0; i < num_queues; i++) {
+		std::string id = std::to_string(i);
+		bool synced = random() % 8 == 0;
+		TaskQueue<TestApp>& queue = synced ? f.runner.createTaskQueue(1 + random() % 3, "group" + std::to_string(random() % 4)) : f.runner.createTaskQueue();
+		for (int step = 0, steps = 1 + random() % 5; step < steps; step++) {
+			switch (random() % 8) {
+				case 0: queue.wait_ms(random() % 60); break;
+				case 1: queue.then(logs(id)); break;
+				case 2: queue.then_on_draw(logs("d" + id)); break;
+				case 3: synced ? queue.wait_sync_ms(random() % 40) : queue.wait_ms(5); break;
+				case 4: queue.then_program(program); break;
+				case 5: queue.then_any([id](TaskQueue<TestApp>& child) { child.wait_ms(10).then(logs("x" + id)); },
+					[id](TaskQueue<TestApp>& child) { child.then(logs("y" + id)).wait_ms(30).then(logs("z" + id)); }); break;
+				case 6: queue.wait_for_event("event").then(logs("e" + id)); break;
+				case 7: queue.then([](TestApp& app) { app.checks++; }); break;
+			}
+		}
+		if (random() % 10 == 0) {
+			tokens.push_back(queue.getCancelToken());
+		}
+	}
+	for (int frame = 0; frame < 60; frame++) {
+		if (frame % 10 == 5) {
+			f.runner.notify("event");
+		}
+		if (frame % 7 == 3 && !tokens.empty()) {
+			tokens.back().cancel();
+			tokens.pop_back();
+		}
+		f.frame(7);
+		auto stats = f.runner.getStats();
+		f.app.log.push_back("frame " + std::to_string(stats.pending_task_count) + " " + std::to_string(stats.waiting_task_queue_count)
+			+ " " + std::to_string(stats.wait_lateness.getCount()) + " " + std::to_string(f.app.checks));
+	}
+	return f.app.log;
+}
+
+static void testParallelMatchesSerial() {
+	auto serial = runMixedQueues(0, 3000);
+	CHECK(serial.size() > 3000);
+	for (size_t thread_count : { 1, 3 }) {
+		CHECK(runMixedQueues(thread_count, 3000) == serial);
+	}
+	// (queues parked on deferred callbacks)
+	auto serial_budget = runMixedQueues(0, 3000, 200);
+	CHECK(serial_budget != serial);
+	CHECK(runMixedQueues(3, 3000, 200) == serial_budget);
+}
+
+//========================================================================
+struct TestCase {
+	const char* name;
+	void (*run)();
+};
+
+int main(int argc, char** argv) {
+	const TestCase tests[] = {
+		{ "wait_then", testWaitThen },
+		{ "handle_expires_after_slot_reuse", testHandleExpiresAfterSlotReuse },
+		{ "virtual_clock", testVirtualClock },
+		{ "steady_clock", testSteadyClock },
+		{ "step_order", testStepOrder },
+		{ "drift_free", testDriftFree },
+		{ "drift_free_default", testDriftFreeDefault },
+		{ "then_async", testThenAsync },
+		{ "then_async_exception", testThenAsyncException },
+		{ "cancel", testCancel },
+		{ "cancel_children", testCancelChildren },
+		{ "cancel_children_of_finished_queue", testCancelChildrenOfFinishedQueue },
+		{ "clear_in_child_callback", testClearInChildCallback },
+		{ "cancel_by_name_and_task_id", testCancelByNameAndTaskId },
+		{ "anonymous_names", testAnonymousNames },
+		{ "indexes_shrink", testIndexesShrink },
+		{ "cancelled_deadlines_are_compacted", testCancelledDeadlinesAreCompacted },
+		{ "wait_for_event", testWaitForEvent },
+		{ "cancelled_event_waiters_are_pruned", testCancelledEventWaitersArePruned },
+		{ "wait_until", testWaitUntil },
+		{ "post_task_queue", testPostTaskQueue },
+		{ "post_task_queue_while_updating", testPostTaskQueueWhileUpdating },
+		{ "sync_release", testSyncRelease },
+		{ "sync_cancelled_member_leaves", testSyncCancelledMemberLeaves },
+		{ "sync_ignores_queues_without_sync_wait", testSyncIgnoresQueuesWithoutSyncWait },
+		{ "sync_thread_safe", testSyncThreadSafe },
+		{ "join_all", testJoinAll },
+		{ "join_any", testJoinAny },
+		{ "program", testProgram },
+		{ "program_between_steps", testProgramBetweenSteps },
+		{ "repeat", testRepeat },
+		{ "loop", testLoop },
+		{ "program_repeat", testProgramRepeat },
+		{ "every_ms", testEveryMs },
+		{ "repeat_zero_keeps_steps", testRepeatZeroKeepsSteps },
+		{ "null_program", testNullProgram },
+		{ "graph", testGraph },
+		{ "update_budget", testUpdateBudget },
+		{ "update_budget_keeps_step_order", testUpdateBudgetKeepsStepOrder },
+		{ "update_budget_delays_following_wait", testUpdateBudgetDelaysFollowingWait },
+		{ "update_budget_runs_whole_queue_within_budget", testUpdateBudgetRunsWholeQueueWithinBudget },
+		{ "critical_tasks_dont_use_task_budget", testCriticalTasksDontUseTaskBudget },
+		{ "stats", testStats },
+		{ "histogram", testHistogram },
+		{ "tween", testTween },
+		{ "cancel_stops_tween", testCancelStopsTween },
+#ifdef OFX_TASKRUNNER_PMR
+		{ "memory_resource", testMemoryResource },
+#endif
+#ifdef OFX_TASKRUNNER_SHARED_MEMORY_SYNC
+		{ "shared_memory_sync", testSharedMemorySync },
+		{ "shared_memory_release_time", testSharedMemoryReleaseTime },
+		{ "shared_memory_member_limit", testSharedMemoryMemberLimit },
+#endif
+#ifdef OFX_TASKRUNNER_TRACE
+		{ "trace", testTrace },
+		{ "trace_ring_buffer", testTraceRingBuffer },
+#endif
+		{ "parallel_matches_serial", testParallelMatchesSerial },
+	};
+
+	int run_count = 0;
+	for (const TestCase& test : tests) {
+		if (argc > 1 && std::strcmp(argv[1], test.name) != 0) {
+			continue;
+		}
+		int failures_before = failure_count;
+		test.run();
+		std::printf("%-32s %s\n", test.name, failure_count == failures_before ? "ok" : "FAILED");
+		run_count++;
+	}
+	if (run_count == 0) {
+		std::fprintf(stderr, "unknown test: %s\n", argv[1]);
+		return 1;
+	}
+	return failure_count == 0 ? 0 : 1;
+}